@@ -0,0 +1,281 @@
+/**************************************************************************/
+/* ST_checkpoint.c
+    Function definitions for writing and reading checkpoints. See
+    ST_checkpoint.h for a description of what a checkpoint holds.
+
+    A checkpoint file starts with a CheckpointHeader followed by one block
+    per plot, written by checkpoint_WritePlot(). Gridded mode writes the
+    plots of its cells in row-major order, non-gridded mode writes its only
+    plot. A new checkpoint is written to a temporary file and renamed over
+    the old one, so an interrupted write never destroys the last good
+    checkpoint.
+ */
+/**************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "ST_checkpoint.h"
+#include "ST_steppe.h"
+#include "ST_globals.h"
+#include "ST_stats.h"
+#include "ST_context.h"
+#include "sw_src/filefuncs.h"
+#include "sw_src/myMemory.h"
+#include "sxw.h"
+
+/* Spells "STCP", marks a file as a checkpoint. */
+#define CHECKPOINT_MAGIC 0x53544350
+
+/* Functions from sxw.c */
+transp_t* getTranspWindow(void);
+
+/*************** Local Function(s). Treat these as private. ***************/
+
+static Bool _transfer_plot(FILE *f, Bool write);
+static Bool _transfer_species(FILE *f, SppIndex sp, Bool write);
+static Bool _transfer_rgroup(FILE *f, GrpIndex rg, Bool write);
+static Bool _transfer_transp_window(FILE *f, Bool write);
+static Bool _transfer(FILE *f, void *data, size_t size, size_t count, Bool write);
+static void _temporary_name(char *name, const char *fileName);
+
+/*********************** Function Definitions *****************************/
+
+/* Describe the current run in header. Pass 1, 1, 0, 1 for rows, cols, begin
+   and end in non-gridded mode. inputChecksum covers the input files the run
+   read. iterationsDone is set to 0. */
+void checkpoint_InitHeader(CheckpointHeader *header, int rows, int cols, int begin, int end,
+                           unsigned int inputChecksum){
+	header->magic = CHECKPOINT_MAGIC;
+	header->rows = rows;
+	header->cols = cols;
+	header->begin = begin;
+	header->end = end;
+	header->years = SuperGlobals.runModelYears;
+	header->iterations = SuperGlobals.runModelIterations;
+	header->grpCount = Globals->grpCount;
+	header->sppCount = Globals->sppCount;
+	header->seed = (int) SuperGlobals.randseed;
+	header->iterationsDone = 0;
+	header->inputChecksum = inputChecksum;
+}
+
+/* Fold the contents of fileName into sum with 32-bit FNV-1a and return the
+   result. Start with CHECKPOINT_CHECKSUM_START. */
+unsigned int checkpoint_ChecksumFile(unsigned int sum, const char *fileName){
+	FILE *f = OpenFile(fileName, "rb");
+	int c;
+
+	while((c = getc(f)) != EOF){
+		sum = (sum ^ (unsigned char) c) * 16777619u;
+	}
+	CloseFile(&f);
+	return sum;
+}
+
+/* Start writing a new checkpoint for fileName. Write the plots with
+   checkpoint_WritePlot(), then call checkpoint_Commit(). */
+FILE *checkpoint_Create(const char *fileName, const CheckpointHeader *header){
+	char temporaryName[1024];
+	FILE *f;
+
+	_temporary_name(temporaryName, fileName);
+	f = OpenFile(temporaryName, "wb");
+	if(fwrite(header, sizeof(CheckpointHeader), 1, f) != 1){
+		LogError(logfp, LOGFATAL, "Could not write checkpoint %s", temporaryName);
+	}
+	return f;
+}
+
+/* Finish a checkpoint started by checkpoint_Create(). It replaces the
+   previous checkpoint only once it has been written completely. */
+void checkpoint_Commit(FILE *f, const char *fileName){
+	char temporaryName[1024];
+
+	_temporary_name(temporaryName, fileName);
+	if(fflush(f) != 0 || ferror(f)){
+		LogError(logfp, LOGFATAL, "Could not write checkpoint %s", temporaryName);
+	}
+	CloseFile(&f);
+	if(rename(temporaryName, fileName) != 0){
+		LogError(logfp, LOGFATAL, "Could not replace checkpoint %s with %s", fileName, temporaryName);
+	}
+}
+
+/* Open the checkpoint fileName for reading its plots with
+   checkpoint_ReadPlot(). header must describe the current run (see
+   checkpoint_InitHeader). It is an error if the checkpoint was written by a
+   different run. On return header->iterationsDone holds the number of
+   iterations the checkpoint covers. */
+FILE *checkpoint_Open(const char *fileName, CheckpointHeader *header){
+	CheckpointHeader read;
+	FILE *f = OpenFile(fileName, "rb");
+
+	if(fread(&read, sizeof(CheckpointHeader), 1, f) != 1 || read.magic != CHECKPOINT_MAGIC){
+		LogError(logfp, LOGFATAL, "%s is not a checkpoint.", fileName);
+	}
+	header->iterationsDone = read.iterationsDone;
+	if(read.seed != header->seed){
+		LogError(logfp, LOGFATAL, "Checkpoint %s was written with seed %ld, not %ld.",
+		         fileName, SimContext_InputSeed(read.seed), SimContext_InputSeed(header->seed));
+	}
+	if(read.inputChecksum != header->inputChecksum){
+		LogError(logfp, LOGFATAL, "The input files changed since checkpoint %s was written.", fileName);
+	}
+	if(memcmp(&read, header, sizeof(CheckpointHeader)) != 0){
+		LogError(logfp, LOGFATAL, "Checkpoint %s was written by a run with different inputs "
+		         "or a different --cells range.", fileName);
+	}
+	if(read.iterationsDone < 1 || read.iterationsDone > read.iterations){
+		LogError(logfp, LOGFATAL, "Checkpoint %s is corrupt.", fileName);
+	}
+	return f;
+}
+
+/* Write the state of the plot that is currently loaded. */
+Bool checkpoint_WritePlot(FILE *f){
+	return _transfer_plot(f, TRUE);
+}
+
+/* Overwrite the state of the plot that is currently loaded with a block
+   written by checkpoint_WritePlot(). */
+Bool checkpoint_ReadPlot(FILE *f){
+	return _transfer_plot(f, FALSE);
+}
+
+/* Write or read everything one plot carries between iterations. The order
+   is the same in both directions. */
+static Bool _transfer_plot(FILE *f, Bool write){
+	SppIndex sp;
+	GrpIndex rg;
+	Bool ok = write ? stat_Write_Accumulators(f) : stat_Read_Accumulators(f);
+
+	ForEachSpecies(sp){
+		ok = ok && _transfer_species(f, sp, write);
+	}
+	ForEachGroup(rg){
+		ok = ok && _transfer_rgroup(f, rg, write);
+	}
+
+	ok = ok && _transfer(f, Env, sizeof(EnvType), 1, write);
+	ok = ok && _transfer(f, Plot, sizeof(PlotType), 1, write);
+	ok = ok && _transfer(f, Succulent, sizeof(SucculentType), 1, write);
+
+	return ok && _transfer_transp_window(f, write);
+}
+
+/* Write or read Species[sp], its arrays and its individuals. When reading,
+   the members that point to memory keep pointing to this plot's memory and
+   the individuals are rebuilt. */
+static Bool _transfer_species(FILE *f, SppIndex sp, Bool write){
+	SpeciesType saved = *Species[sp];
+	IndivType *ndv, *prev = NULL;
+	int count = 0;
+	Bool ok;
+
+	ok = _transfer(f, Species[sp], sizeof(SpeciesType), 1, write);
+	if(!write){
+		Species[sp]->kills = saved.kills;
+		Species[sp]->seedprod = saved.seedprod;
+		Species[sp]->name = saved.name;
+		Species[sp]->IndvHead = saved.IndvHead;
+		Species[sp]->indivs = saved.indivs;
+		Species[sp]->indivCapacity = saved.indivCapacity;
+		Species[sp]->indivSpare = saved.indivSpare;
+		Species[sp]->indivSpareCapacity = saved.indivSpareCapacity;
+		Species[sp]->indivUsed = saved.indivUsed;
+	}
+
+	if(Species[sp]->kills){
+		ok = ok && _transfer(f, Species[sp]->kills, sizeof(IntUS), SppMaxAge(sp), write);
+	}
+	if(Species[sp]->seedprod){
+		ok = ok && _transfer(f, Species[sp]->seedprod, sizeof(IntUS), Species[sp]->viable_yrs, write);
+	}
+
+	if(write){
+		for(ndv = Species[sp]->IndvHead; ndv; ndv = ndv->Next){
+			count++;
+		}
+		ok = ok && _transfer(f, &count, sizeof(int), 1, TRUE);
+		for(ndv = Species[sp]->IndvHead; ndv; ndv = ndv->Next){
+			ok = ok && _transfer(f, ndv, sizeof(IndivType), 1, TRUE);
+		}
+		return ok;
+	}
+
+	Indiv_Clear(Species[sp]);
+
+	ok = ok && _transfer(f, &count, sizeof(int), 1, FALSE) && count >= 0;
+	if(ok){
+		Indiv_Reserve(Species[sp], count);
+	}
+	for(; ok && count > 0; --count){
+		ndv = Indiv_Alloc(Species[sp]);
+		ok = _transfer(f, ndv, sizeof(IndivType), 1, FALSE);
+		ndv->Prev = prev;
+		ndv->Next = NULL;
+		if(prev){
+			prev->Next = ndv;
+		} else {
+			Species[sp]->IndvHead = ndv;
+		}
+		prev = ndv;
+	}
+	return ok;
+}
+
+/* Write or read RGroup[rg] and its arrays. */
+static Bool _transfer_rgroup(FILE *f, GrpIndex rg, Bool write){
+	GroupType saved = *RGroup[rg];
+	Bool ok;
+
+	ok = _transfer(f, RGroup[rg], sizeof(GroupType), 1, write);
+	if(!write){
+		RGroup[rg]->kills = saved.kills;
+		RGroup[rg]->est_spp = saved.est_spp;
+		RGroup[rg]->species = saved.species;
+		RGroup[rg]->name = saved.name;
+		RGroup[rg]->sorted = saved.sorted;
+		RGroup[rg]->sortScratch = saved.sortScratch;
+		RGroup[rg]->sortedCapacity = saved.sortedCapacity;
+		RGroup_InvalidateSorted(RGroup[rg]);
+	}
+
+	if(RGroup[rg]->kills){
+		ok = ok && _transfer(f, RGroup[rg]->kills, sizeof(IntUS), GrpMaxAge(rg), write);
+	}
+	ok = ok && _transfer(f, RGroup[rg]->est_spp, sizeof(SppIndex), SuperGlobals.max_spp_per_grp, write);
+	ok = ok && _transfer(f, RGroup[rg]->species, sizeof(SppIndex), SuperGlobals.max_spp_per_grp, write);
+	return ok;
+}
+
+/* Write or read the SXW transpiration window of the loaded plot. */
+static Bool _transfer_transp_window(FILE *f, Bool write){
+	transp_t *window = getTranspWindow();
+	transp_t saved = *window;
+	Bool ok;
+
+	ok = _transfer(f, window, sizeof(transp_t), 1, write);
+	if(!write){
+		window->ratios = saved.ratios;
+		window->transp = saved.transp;
+		window->SoS_array = saved.SoS_array;
+		window->size = saved.size;
+	}
+
+	ok = ok && _transfer(f, window->ratios, sizeof(RealF), window->size, write);
+	ok = ok && _transfer(f, window->transp, sizeof(RealF), window->size, write);
+	return ok && _transfer(f, window->SoS_array, sizeof(RealF), window->size, write);
+}
+
+/* fwrite or fread count elements of the given size. Returns TRUE if all
+   elements were transferred. */
+static Bool _transfer(FILE *f, void *data, size_t size, size_t count, Bool write){
+	size_t done = write ? fwrite(data, size, count, f) : fread(data, size, count, f);
+	return (Bool) (done == count);
+}
+
+/* The name a checkpoint is written to before it replaces fileName. */
+static void _temporary_name(char *name, const char *fileName){
+	sprintf(name, "%s.tmp", fileName);
+}
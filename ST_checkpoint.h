@@ -0,0 +1,67 @@
+/******************************************************************/
+/* ST_checkpoint.h
+    Defines all exported objects from ST_checkpoint.c.
+
+    A checkpoint holds everything a simulation carries from one
+    iteration to the next: the statistics accumulators and the STEPPE
+    state of every plot, individuals included. Random number
+    generators are not stored because checkpoints require --streams,
+    where every iteration seeds its own streams (see
+    SimContext_SeedProcessRNGs), and SOILWAT2 is reset between
+    iterations, so neither carries any state across the boundary.
+
+    Checkpoints are written between iterations when --checkpoint=N is
+    given. --resume reads the checkpoint and continues with the next
+    iteration, producing the same output as an uninterrupted run.
+*/
+/******************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include "ST_defines.h"
+
+/*********************** Structure(s) ****************************/
+
+/* Describes the run that wrote a checkpoint. A checkpoint can only be
+   resumed by a run with the same description. */
+struct checkpoint_header_st
+{
+	int magic,
+	    rows,            /* 1 in non-gridded mode */
+	    cols,            /* 1 in non-gridded mode */
+	    begin,           /* first cell of --cells, 0 in non-gridded mode */
+	    end,             /* one past the last cell of --cells */
+	    years,
+	    iterations,
+	    grpCount,
+	    sppCount,
+	    seed,            /* SuperGlobals.randseed */
+	    iterationsDone;  /* Iterations finished when the checkpoint was written */
+	unsigned int inputChecksum; /* See checkpoint_ChecksumFile() */
+} typedef CheckpointHeader;
+
+/* First value to pass to checkpoint_ChecksumFile(). */
+#define CHECKPOINT_CHECKSUM_START 2166136261u
+
+/******************** Exported Function(s) ************************/
+
+void checkpoint_InitHeader(CheckpointHeader *header, int rows, int cols, int begin, int end,
+                           unsigned int inputChecksum);
+unsigned int checkpoint_ChecksumFile(unsigned int sum, const char *fileName);
+FILE *checkpoint_Create(const char *fileName, const CheckpointHeader *header);
+void checkpoint_Commit(FILE *f, const char *fileName);
+FILE *checkpoint_Open(const char *fileName, CheckpointHeader *header);
+Bool checkpoint_WritePlot(FILE *f);
+Bool checkpoint_ReadPlot(FILE *f);
+
+/************************ Exported variables ****************************/
+
+/* Write a checkpoint after every checkpointInterval iterations. 0 disables
+   checkpoints. Set with --checkpoint=N. */
+int checkpointInterval;
+/* TRUE if the run should continue from its checkpoint. Set with --resume. */
+Bool resumeFromCheckpoint;
+
+#endif
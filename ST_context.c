@@ -0,0 +1,247 @@
+/**************************************************************************/
+/* ST_context.c
+    Function definitions for binding a SimContext to the STEPPE modules.
+    See ST_context.h for a description of the SimContext struct.
+ */
+/**************************************************************************/
+
+#include "ST_context.h"
+#include "ST_globals.h"
+#include "ST_initialization.h"
+#include <limits.h>
+#include "sw_src/rands.h"
+
+extern Bool *_SomeKillage;				// From ST_mortality.c
+extern Bool QuietMode;					// From ST_main.c
+
+extern pcg32_random_t environs_rng;     // Used exclusively in ST_environs.c
+extern pcg32_random_t resgroups_rng;    // Used exclusively in ST_resgroups.c
+extern pcg32_random_t species_rng;      // Used exclusively in ST_species.c
+extern pcg32_random_t markov_rng;       // Used exclusively in SW_Markov.c
+extern pcg32_random_t resource_rng;     // Used exclusively in sxw_resource.c
+extern pcg32_random_t grid_rng;         // Gridded mode's unique RNG.
+extern pcg32_random_t dispersal_rng;    // From ST_seedDispersal.c
+
+/* Functions from sxw.c */
+void copy_sxw_variables(SXW_t* newSXW, SXW_resourceType* newSXWResources, transp_t* newTransp_window);
+
+/*************** Local Function(s). Treat these as private. ***************/
+
+static pcg32_random_t *_process_rng(Context_RNG_Indices which);
+static uint64_t _stream_id(unsigned long cell, IntS iter, RNG_Subsystem subsystem);
+static uint64_t _mix(uint64_t x);
+
+/* Largest cell number and iteration _stream_id() can tell apart. */
+#define MAX_STREAM_CELL      ((UINT64_C(1) << 35) - 1)
+#define MAX_STREAM_ITERATION ((UINT64_C(1) << 24) - 1)
+
+/*************************** Global Variable(s) ***************************/
+
+Bool useRNGStreams;
+
+/*************************** Local Variable(s) ****************************/
+
+/* RNG states of the bound context. The process-wide generators are copied
+   back into them when the context is replaced or cleared. */
+static pcg32_random_t *_boundRNGs = NULL;
+
+/* Set by SimContext_SetSeed. Every stream is derived from it. */
+static uint64_t _rootSeed = 0;
+
+/*********************** Function Definitions *****************************/
+
+/* Copy the members of ctx into the process-wide variables the STEPPE
+   modules read. Anything that was bound before is replaced. Only the RNG states are copied back into the
+   previous context; its other members are either pointers into the owner's
+   memory or flags that the owner sets directly. */
+void SimContext_Bind(const SimContext *ctx){
+	int i;
+
+	if(_boundRNGs){
+		for(i = 0; i < N_CONTEXT_RNGS; ++i){
+			_boundRNGs[i] = *_process_rng(i);
+		}
+	}
+	_boundRNGs = ctx->rngs;
+	if(_boundRNGs){
+		for(i = 0; i < N_CONTEXT_RNGS; ++i){
+			*_process_rng(i) = _boundRNGs[i];
+		}
+	}
+
+	RGroup = ctx->rgroup;
+	Species = ctx->species;
+	Succulent = ctx->succulent;
+	Env = ctx->env;
+	Plot = ctx->plot;
+	Globals = ctx->globals;
+
+	DuringInitialization = ctx->duringInitialization;
+	setCheatgrassPrecip(ctx->cheatgrassPrecip);
+	_SomeKillage = ctx->someKillage;
+	UseCheatgrassWildfire = ctx->useCheatgrassWildfire;
+
+	stat_Copy_Accumulators(ctx->_Dist, ctx->_Ppt, ctx->_Temp, ctx->_Grp, ctx->_Gsize,
+	                       ctx->_Gpr, ctx->_Gmort, ctx->_Gestab, ctx->_Spp, ctx->_Indv,
+	                       ctx->_Smort, ctx->_Sestab, ctx->_Sreceived, ctx->_Gwf,
+	                       ctx->stats_init);
+
+	copy_sxw_variables(ctx->sxw, ctx->sxwResources, ctx->transpWindow);
+}
+
+/* Nullify all state bound by SimContext_Bind so a stale context can not be
+   modified by accident. */
+void SimContext_Clear(void){
+	int i;
+
+	if(_boundRNGs){
+		for(i = 0; i < N_CONTEXT_RNGS; ++i){
+			_boundRNGs[i] = *_process_rng(i);
+		}
+		_boundRNGs = NULL;
+	}
+
+	Species = NULL;
+	RGroup = NULL;
+	Succulent = NULL;
+	Env = NULL;
+	Plot = NULL;
+	Globals = NULL;
+	stat_Copy_Accumulators(NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,FALSE);
+	copy_sxw_variables(NULL,NULL,NULL);
+}
+
+/* Settle the seed of this run and derive every random number stream from
+   it. With --streams a seed of 0 in the model input file is replaced by one
+   drawn from the clock, once, here. It is stored in SuperGlobals.randseed and
+   printed, so the run can be repeated by putting it into the input file.
+   Without --streams a seed of 0 is kept: the generators are then reseeded
+   from the clock in every iteration, which is what tells the iterations apart
+   in that mode. Call this once after the inputs are read and before any
+   generator is seeded. */
+void SimContext_SetSeed(void){
+	pcg32_random_t rng;
+
+	if(SuperGlobals.randseed == 0 && useRNGStreams){
+		RandSeed(0, &rng);
+		/* Negative like the seeds ST_params.c reads from the input file */
+		SuperGlobals.randseed = -(IntL) pcg32_boundedrand_r(&rng, INT_MAX) - 1;
+	}
+	if(!QuietMode){
+		if(SuperGlobals.randseed){
+			printf("Random seed: %ld\n", SimContext_InputSeed(SuperGlobals.randseed));
+		} else {
+			printf("Random seed: from the clock in every iteration\n");
+		}
+	}
+
+	RandSeed(SuperGlobals.randseed, &rng);
+	_rootSeed = ((uint64_t) pcg32_random_r(&rng) << 32) | pcg32_random_r(&rng);
+}
+
+/* The seed to show the user for a seed as it is stored in
+   SuperGlobals.randseed, shard files and checkpoints. ST_params.c stores the
+   seed of the input file negated, so this is the number to put into the
+   input file to repeat the run. */
+long SimContext_InputSeed(IntL seed){
+	return (seed < 0) ? -(long) seed : (long) seed;
+}
+
+/* Seed rng with the stream that belongs to subsystem in the given cell and
+   iteration. The stream only depends on these three numbers and the seed
+   settled by SimContext_SetSeed, never on which streams were seeded or used
+   before. Non-gridded runs use cell 0 and spinup uses iteration 0.
+   Without --streams rng is seeded with RandSeed() and the run's seed, like
+   every generator was before streams existed. */
+void SimContext_SeedStream(pcg32_random_t *rng, unsigned long cell, IntS iter, RNG_Subsystem subsystem){
+	uint64_t id;
+
+	if(!useRNGStreams){
+		RandSeed(SuperGlobals.randseed, rng);
+		return;
+	}
+
+	id = _stream_id(cell, iter, subsystem);
+	pcg32_srandom_r(rng, _mix(_rootSeed ^ id), id);
+}
+
+/* Seed the N_CONTEXT_RNGS states in rngs with the streams of the given cell
+   and iteration. */
+void SimContext_SeedRNGs(pcg32_random_t *rngs, unsigned long cell, IntS iter){
+	int i;
+
+	for(i = 0; i < N_CONTEXT_RNGS; ++i){
+		SimContext_SeedStream(&rngs[i], cell, iter, i);
+	}
+}
+
+/* Seed the process-wide generators for iteration iter. The generators a
+   context carries get the streams of cell 0, which is what non-gridded runs
+   draw from. grid_rng and dispersal_rng get their own streams, shared by all
+   cells. This function must be called while no context is bound.
+
+   Without --streams the generators are reseeded with the run's seed in the
+   order they always were, and resource_rng and dispersal_rng keep running
+   from one iteration into the next. This keeps the results of earlier
+   versions, but an iteration then depends on the ones before it. */
+void SimContext_SeedProcessRNGs(IntS iter){
+	int i;
+
+	if(!useRNGStreams){
+		RandSeed(SuperGlobals.randseed, &environs_rng);
+		RandSeed(SuperGlobals.randseed, &mortality_rng);
+		RandSeed(SuperGlobals.randseed, &resgroups_rng);
+		RandSeed(SuperGlobals.randseed, &species_rng);
+		RandSeed(SuperGlobals.randseed, &grid_rng);
+		RandSeed(SuperGlobals.randseed, &markov_rng);
+		return;
+	}
+
+	for(i = 0; i < N_CONTEXT_RNGS; ++i){
+		SimContext_SeedStream(_process_rng(i), 0, iter, i);
+	}
+	SimContext_SeedStream(&grid_rng, 0, iter, RNG_GRID);
+	SimContext_SeedStream(&dispersal_rng, 0, iter, RNG_DISPERSAL);
+}
+
+/* A unique pcg32 sequence id for each (cell, iteration, subsystem). The
+   subsystem takes 4 bits and the iteration 24. pcg32 discards the top bit,
+   which leaves 35 bits for the cell. Anything outside of these bounds would
+   share a stream with another (cell, iteration, subsystem), so it is fatal. */
+static uint64_t _stream_id(unsigned long cell, IntS iter, RNG_Subsystem subsystem){
+	if(iter < 0 || (uint64_t) iter > MAX_STREAM_ITERATION
+	   || (uint64_t) cell > MAX_STREAM_CELL || (unsigned) subsystem >= 16){
+		LogError(logfp, LOGFATAL, "No random number stream for cell %lu, iteration %d, subsystem %d. "
+		         "Streams exist for at most %llu cells and %llu iterations.", cell, iter, (int) subsystem,
+		         (unsigned long long) MAX_STREAM_CELL + 1, (unsigned long long) MAX_STREAM_ITERATION);
+	}
+
+	return ((uint64_t) cell << 28) | ((uint64_t) iter << 4) | (uint64_t) subsystem;
+}
+
+/* splitmix64 finalizer. Spreads nearby stream ids over the whole state space
+   so neighbouring streams do not start from related states. */
+static uint64_t _mix(uint64_t x){
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+/* Returns the process-wide generator that the modules draw from. */
+static pcg32_random_t *_process_rng(Context_RNG_Indices which){
+	switch(which){
+		case RNG_ENVIRONS:
+			return &environs_rng;
+		case RNG_MORTALITY:
+			return &mortality_rng;
+		case RNG_RESGROUPS:
+			return &resgroups_rng;
+		case RNG_SPECIES:
+			return &species_rng;
+		case RNG_MARKOV:
+			return &markov_rng;
+		case RNG_RESOURCE:
+		default:
+			return &resource_rng;
+	}
+}
@@ -0,0 +1,113 @@
+/******************************************************************/
+/* ST_context.h
+    Defines the SimContext struct and the functions exported from
+    ST_context.c.
+
+    A SimContext groups the pointers load_cell() in ST_grid.c used to
+    swap one at a time when it switched cells: the RGroup, Species,
+    Succulent, Env, Plot and Globals structures, the mortality flags,
+    the ST_stats.c accumulators, the sxw.c SXW variables and the random
+    number generators. SimContext_Bind() copies them into the
+    process-wide variables and SimContext_Clear() resets those.
+
+    No STEPPE or SXW function takes a context. rgroup_*, mort_*, stat_*,
+    Env_Generate and SXW_* still read the process-wide variables, so
+    nothing here is reentrant and only one context can be bound at a
+    time.
+*/
+/******************************************************************/
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "ST_defines.h"
+#include "ST_stats.h"
+#include "ST_mortality.h"
+#include "sxw_vars.h"
+#include "sw_src/pcg/pcg_basic.h"
+
+/*********************** Enumerator(s) ****************************/
+
+/* Indices of the random number generators a context carries. Every one of
+   them is only used while simulating a single plot, which is what allows
+   plots to be simulated in any order. grid_rng and dispersal_rng couple
+   cells and stay process-wide. */
+typedef enum
+{
+	RNG_ENVIRONS,
+	RNG_MORTALITY,
+	RNG_RESGROUPS,
+	RNG_SPECIES,
+	RNG_MARKOV,
+	RNG_RESOURCE,
+
+	/* Automatically generate number of RNGs since enums start at 0 */
+	N_CONTEXT_RNGS
+} Context_RNG_Indices;
+
+/* Every subsystem that draws random numbers, used to pick its stream. The
+   generators a context carries come first, followed by the generators that
+   are shared by all cells. At most 16 subsystems fit in a stream id. */
+typedef enum
+{
+	RNG_GRID = N_CONTEXT_RNGS,
+	RNG_DISPERSAL,
+
+	N_RNG_SUBSYSTEMS
+} RNG_Subsystem;
+
+/*********************** Structure(s) ****************************/
+
+struct sim_context_st
+{
+	/* ------------------ STEPPE state ------------------ */
+	GroupType **rgroup;
+	SpeciesType **species;
+	SucculentType *succulent;
+	EnvType *env;
+	PlotType *plot;
+	ModelType *globals;
+	CheatgrassPrecip *cheatgrassPrecip;
+	Bool *someKillage;
+	Bool useCheatgrassWildfire;
+	Bool duringInitialization;
+
+	/* ---------------- accumulators -------------------- */
+	StatType *_Dist, *_Ppt, *_Temp,
+		*_Grp, *_Gsize, *_Gpr, *_Gmort, *_Gestab,
+		*_Spp, *_Indv, *_Smort, *_Sestab, *_Sreceived;
+	FireStatsType *_Gwf;
+	Bool stats_init;
+
+	/* -------------------- SXW ------------------------- */
+	SXW_t *sxw;
+	SXW_resourceType *sxwResources;
+	transp_t *transpWindow;
+
+	/* ---------------- RNG states ---------------------- */
+	/* N_CONTEXT_RNGS states owned by the context, or NULL to keep using the
+	   process-wide generators. */
+	pcg32_random_t *rngs;
+} typedef SimContext;
+
+/******************** Exported Function(s) ************************/
+
+void SimContext_Bind(const SimContext *ctx);
+void SimContext_Clear(void);
+void SimContext_SetSeed(void);
+long SimContext_InputSeed(IntL seed);
+void SimContext_SeedStream(pcg32_random_t *rng, unsigned long cell, IntS iter, RNG_Subsystem subsystem);
+void SimContext_SeedRNGs(pcg32_random_t *rngs, unsigned long cell, IntS iter);
+void SimContext_SeedProcessRNGs(IntS iter);
+
+/************************ Exported variables ****************************/
+
+/* TRUE if every (cell, iteration, subsystem) draws from its own random number
+   stream. Set with --streams. FALSE keeps the legacy order, in which all
+   cells share the process-wide generators and every iteration reseeds them
+   with the run's seed, so results match those of earlier versions. Running
+   iterations or cells in other processes or resuming from a checkpoint needs
+   streams. Defined in ST_context.c. */
+extern Bool useRNGStreams;
+
+#endif
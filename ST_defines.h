@@ -73,8 +73,8 @@
 /**
  * \brief Means "sort this array in ascending order".
  * 
- * \sa Indiv_SortSize() is one function that could take this
- *                      as a parameter.
+ * \sa Indiv_MergeSortSize() is one function that could take this
+ *                           as a parameter.
  * 
  * \ingroup STEPPE
  */
@@ -82,8 +82,8 @@
 /**
  * \brief Means "sort this array in descending order".
  * 
- * \sa Indiv_SortSize() is one function that could take this
- *                      as a parameter.
+ * \sa Indiv_MergeSortSize() is one function that could take this
+ *                           as a parameter.
  * 
  * \ingroup STEPPE
  */
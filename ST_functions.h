@@ -35,7 +35,8 @@ void copy_succulent(const SucculentType* src, SucculentType* dest);
  */
 char *Parm_name(ST_FileIndex i);
 
-IndivType **RGroup_GetIndivs( GrpIndex rg, const char sort, IntS *num);
+IndivType **RGroup_SortedIndivs( GrpIndex rg, const char sort, IntS *num);
+void RGroup_InvalidateSorted( GroupType *g);
 GrpIndex RGroup_New( void);
 void RGroup_Kill( GrpIndex rg);
 GrpIndex RGroup_Name2Index (const char *name);
@@ -54,10 +55,18 @@ void Species_Proportion_Grazing(const SppIndex sp,RealF proportionGrazing );
 void Species_Annual_Kill(const SppIndex sp, int killType);
 IntS Species_NumEstablish( SppIndex sp);
 
-void Indiv_SortSize( const byte sorttype,
-                     const size_t n, IndivType **list);
+void Indiv_MergeSortSize( const byte sorttype, const size_t n,
+                          IndivType **list, IndivType **scratch);
+Bool Indiv_ResortSize( const byte sorttype, const size_t n,
+                       IndivType **list, int *pos, size_t maxShifts);
 int Indiv_CompSize_A( const void *key1, const void *key2);
 int Indiv_CompSize_D( const void *key1, const void *key2);
+IndivType *Indiv_Alloc(SpeciesType *s);
+void Indiv_Reserve(SpeciesType *s, int count);
+void Indiv_Clear(SpeciesType *s);
+IndivType *Indiv_Pack(SpeciesType *s, int *n);
+void Indiv_FreeStorage(SpeciesType *s);
+void Indiv_SetRelsize(IndivType *ndv, RealF relsize);
 
 #ifdef DEBUG_MEM
   void RGroup_SetMemoryRefs(void);
@@ -15,7 +15,8 @@
     cells can be referenced by the gridCells variable which is a 2d array of
     CellTypes. To allow this module to use the same functions as non-gridded
     mode the CellType structs must be loaded into the global variables using
-    the load_cell function. As long as a cell is loaded in you can be sure that
+    the load_cell function, which builds a SimContext (see ST_context.h) from
+    the cell and binds it. As long as a cell is loaded in you can be sure that
     all functions will work as expected.
 
     In addition to all of the functionality of non-gridded mode, gridded mode
@@ -23,6 +24,29 @@
     Initialization allows vegetation to establish before the simulation
     experiments begin. Seed dispersal allows each cell to disperse seeds to
     nearby cells.
+
+    A large grid can be split across processes. Each process is started with
+    --cells=begin:end, simulates only those cells and writes their
+    accumulators to a shard file. A final process started with --merge reads
+    every shard and writes the same cell average files a single process
+    would have written. Shards require uncoupled cells, so seed dispersal
+    can not be used with --cells.
+
+    Each year of the simulation is split in two phases: _run_cell_year()
+    simulates one cell and only touches that cell's state, and
+    _end_grid_year() performs the work that couples cells (seed dispersal).
+    With --streams and without seed dispersal runGrid() runs each cell
+    through all years before moving to the next cell. Every cell then has its
+    own RNG streams and its own copy of the SOILWAT2 state, so both orders
+    give the same results. Without --streams all cells draw from the same
+    generators and continue from the SOILWAT2 state the previous cell left
+    behind, and the year-by-year order is kept so that results match those
+    of earlier versions.
+    The split does not make gridded runs parallel. There is no threaded mode
+    and no per-year worker pool: every cell runs through the same
+    process-wide STEPPE globals and the single SOILWAT2 instance, so cells are
+    stepped one at a time. Large grids are spread over processes with --cells
+    instead.
 */
 
 /*******************************************************/
@@ -44,6 +68,14 @@
 #include "ST_progressBar.h"
 #include "ST_seedDispersal.h"
 #include "ST_mortality.h"
+#include "ST_context.h"
+#include "ST_checkpoint.h"
+#include "ST_scratch.h"
+
+/* Identifies the files written by _write_cell_shard() */
+#define CELL_SHARD_MAGIC 0x53545743
+/* Number of ints at the start of a shard file */
+#define CELL_SHARD_HEADER_SIZE 9
 
 char sd_Sep;
 
@@ -59,16 +91,7 @@ Bool UseDisturbances, UseSoils, sd_DoOutput; //these are treated like booleans
 extern SW_SOILWAT SW_Soilwat;
 extern SW_WEATHER SW_Weather;
 
-extern pcg32_random_t grid_rng;         // Gridded mode's unique RNG.
-
-/* We need to seed these RNGs when using the gridded mode but do not use them in this file. */
-extern pcg32_random_t environs_rng;     // Used exclusively in ST_environs.c
-extern pcg32_random_t resgroups_rng;    // Used exclusively in ST_resgroups.c
-extern pcg32_random_t species_rng;      // Used exclusively in ST_species.c
-extern pcg32_random_t markov_rng;       // Used exclusively in SW_Markov.c
-
 extern Bool UseProgressBar;             // From ST_main.c
-extern Bool *_SomeKillage;				// From ST_mortality.c 
 
 /******** Modular External Function Declarations ***********/
 /* -- truly global functions are declared in functions.h --*/
@@ -89,6 +112,7 @@ void parm_Initialize(void);
 void parm_SetFirstName(char *s);
 void parm_SetName(char *s, int which);
 void parm_free_memory(void);
+unsigned int parm_InputChecksum(void);
 void files_init(void);
 void maxrgroupspecies_init(void);
 
@@ -100,7 +124,6 @@ void deallocate_Globals(Bool isGriddedMode);
 SXW_t* getSXW(void);
 SXW_resourceType* getSXWResources(void);
 transp_t* getTranspWindow(void);
-void copy_sxw_variables(SXW_t* newSXW, SXW_resourceType* newSXWResources, transp_t* newTransp_window);
 
 /***********************************************************/
 /* --------- Locally Used Function Declarations ---------- */
@@ -121,7 +144,19 @@ static void _read_maxrgroupspecies(void);
 static void _read_grid_setup(void);
 static void _read_files(void);
 static void _init_stepwat_inputs(void);
+static void _copy_stepwat_inputs(const CellType *src);
+static void _init_roots_overrides(void);
 static void _init_grid_inputs(void);
+static void _run_iterations(void);
+static void _run_cell_year(int row, int col, IntS year);
+static void _end_grid_year(void);
+static void _check_cell_range(void);
+static void _cell_shard_name(char *name, int begin);
+static void _write_cell_shard(void);
+static void _merge_cell_shards(void);
+static void _checkpoint_header(CheckpointHeader *header, char *fileName);
+static void _write_grid_checkpoint(IntS iterationsDone);
+static IntS _read_grid_checkpoint(void);
 
 /******************** Begin Model Code *********************/
 /***********************************************************/
@@ -152,23 +187,73 @@ static void printGeneralInfo(void){
 /* Run gridded mode. */
 void runGrid(void)
 {
-	int i, j;
-	Bool killedany;
-	IntS year, iter;
-
 	_init_grid_files();				// reads in files.in file
 	_read_maxrgroupspecies();       // reads in maxrgroupspecies.in file
 	_read_grid_setup();             // reads in grid_setup.in file
     _read_files();                  // reads in Stepwat_Inputs/files.in file
     _init_stepwat_inputs();			// reads the stepwat inputs in
+	if((useCellRange || mergeCellShards || checkpointInterval > 0 || resumeFromCheckpoint)
+	   && SuperGlobals.randseed == 0){
+		LogError(logfp, LOGFATAL, "--cells, --merge, --checkpoint and --resume need a seed in "
+		         "the model input file, so every process draws from the same streams.");
+	}
+	SimContext_SetSeed();
 	_init_grid_inputs();			// reads the grid inputs in & initializes the global grid variables
 	//SWC hist file prefix needs to be cleared
 	Mem_Free(SW_Soilwat.hist.file_prefix);
 	SW_Soilwat.hist.file_prefix = NULL;
 
 	printGeneralInfo();
+	_check_cell_range();
+
+	if(mergeCellShards){
+		_merge_cell_shards();
+		if(UseProgressBar){
+			logProgress(0, 0, OUTPUT);
+		}
+	} else {
+		_run_iterations();
+	}
+
+	// Output the Bmass and Mort average statistics (if requested).
+	// A process that only ran part of the grid leaves this to the merge.
+	if(!useCellRange){
+		char fileBMassCellAvg[1024], fileMortCellAvg[1024];
+		if (BmassFlags.summary){
+			sprintf(fileBMassCellAvg, "%s.csv", grid_files[GRID_FILE_PREFIX_BMASSCELLAVG]);
+			_Output_AllCellAvgBmass(fileBMassCellAvg);
+		}
+		if (MortFlags.summary){
+			sprintf(fileMortCellAvg, "%s.csv", grid_files[GRID_FILE_PREFIX_MORTCELLAVG]);
+			_Output_AllCellAvgMort(fileMortCellAvg);
+		}
+	}
+
+	free_grid_memory();	// Free our allocated memory since we do not need it anymore
+	parm_free_memory();		// Free memory allocated to the _files array in ST_params.c
+	if(initializationMethod == INIT_WITH_SPINUP) {
+		freeInitializationMemory();
+	}
+	logProgress(0, 0, DONE);
+}
+
+/* Run initialization and every iteration of the simulation, then write the
+   per-cell output files. If a cell range was requested only those cells are
+   simulated and their accumulators are written to a shard file. */
+static void _run_iterations(void)
+{
+	int i, j;
+	IntS year, iter, firstIter = 1;
+	char checkpointName[1024];
+	CheckpointHeader header;
+
+	if((checkpointInterval > 0 || resumeFromCheckpoint) && !useRNGStreams){
+		LogError(logfp, LOGFATAL, "--checkpoint and --resume require --streams, because without it "
+		         "the random number generators carry state from one iteration into the next.");
+	}
 
 	if(initializationMethod != INIT_WITH_NOTHING){
+		// Initialization is deterministic, so a resumed run simply repeats it.
 		runInitialization();
 	} else {
 		/* SXW expects to be run from the testing.sagebrush.master/Stepwat_Inputs directory.
@@ -184,7 +269,14 @@ void runGrid(void)
 	char SW_prefix_permanent[2048];
 	sprintf(SW_prefix_permanent, "%s/%s", grid_directories[GRID_DIRECTORY_STEPWAT_INPUTS], SW_Weather.name_prefix);
 
-	for (iter = 1; iter <= SuperGlobals.runModelIterations; iter++)
+	if(resumeFromCheckpoint){
+		firstIter = _read_grid_checkpoint() + 1;
+	}
+
+	// Timed separately from initialization so the two can be compared.
+	double start = throughputClock();
+
+	for (iter = firstIter; iter <= SuperGlobals.runModelIterations; iter++)
 	{ //for each iteration
 
 		/*
@@ -193,9 +285,12 @@ void runGrid(void)
 		 */
 		sprintf(SW_Weather.name_prefix, "%s", SW_prefix_permanent); //updates the directory of the weather files so SOILWAT2 can find them
 
-		// Initialize the plot for each grid cell
+		// Initialize the plot for each grid cell this process simulates
 		for (i = 0; i < grid_Rows; i++){
 			for (j = 0; j < grid_Cols; j++){
+				if(!cell_in_range(i, j)){
+					continue;
+				}
 				load_cell(i, j);
 				Plot_Initialize();
 				Globals->currIter = iter;
@@ -208,67 +303,54 @@ void runGrid(void)
 			loadInitializationConditions();
 		}
 
-		RandSeed(SuperGlobals.randseed, &environs_rng);
-		RandSeed(SuperGlobals.randseed, &mortality_rng);
-		RandSeed(SuperGlobals.randseed, &resgroups_rng);
-		RandSeed(SuperGlobals.randseed, &species_rng);
-		RandSeed(SuperGlobals.randseed, &grid_rng);
-		RandSeed(SuperGlobals.randseed, &markov_rng);
-
-		for (year = 1; year <= SuperGlobals.runModelYears; year++)
-		{ //for each year
-			if(UseProgressBar){
-				logProgress(iter, year, SIMULATION);
-			}
+		SimContext_SeedProcessRNGs(iter);
+		seed_cell_rngs(iter);
+
+		if(UseSeedDispersal || !useRNGStreams){
+			/* Cells are coupled, either through seed dispersal or through the
+			   generators they share without --streams, so every cell has to finish
+			   a year before any cell starts the next one. */
+			for (year = 1; year <= SuperGlobals.runModelYears; year++)
+			{ //for each year
+				if(UseProgressBar){
+					logProgress(iter, year, SIMULATION);
+				}
+				for (i = 0; i < grid_Rows; i++){
+					for (j = 0; j < grid_Cols; j++){
+						if(!cell_in_range(i, j)){
+							continue;
+						}
+						load_cell(i, j);
+						_run_cell_year(i, j, year);
+					}
+				}
+
+				/* Cross-cell work. Everything below needs every cell to have finished this year. */
+				_end_grid_year();
+			}/* end model run for this year*/
+		} else {
+			/* Cells are independent, so run each cell through every year before
+			   moving on. This keeps a cell's state in cache and only loads each
+			   cell once per iteration. Every cell has its own RNG streams and
+			   SOILWAT2 state, so the results match the year-by-year order. */
 			for (i = 0; i < grid_Rows; i++){
-				for (j = 0; j < grid_Cols; j++)
-				{ //for each cell
-                
-                    /* Ensure that all global variables reference the specific cell */
+				for (j = 0; j < grid_Cols; j++){
+					if(!cell_in_range(i, j)){
+						continue;
+					}
+					if(UseProgressBar){
+						// Report progress as the fraction of cells finished this iteration.
+						logProgress(iter, ((j + (i * grid_Cols) - cellRangeBegin) * SuperGlobals.runModelYears)
+						                  / (cellRangeEnd - cellRangeBegin), SIMULATION);
+					}
 					load_cell(i, j);
-
-					Globals->currYear = year;
-
-					/* Seed dispersal needs to take into account last year's precipitation, 
-					   so we'll record it before calling Env_Generate(). */
-					if (year > 1 && UseSeedDispersal){
-						gridCells[i][j].mySeedDispersal->lyppt = gridCells[i][j].myEnvironment.ppt;
+					for (year = 1; year <= SuperGlobals.runModelYears; year++){
+						_run_cell_year(i, j, year);
 					}
-
-					/* The following functions mimic ST_main.c. */
-
-					rgroup_Establish(); 		// Establish individuals.
-
-					Env_Generate();				// Run SOILWAT2 to generate resources.
-
-					rgroup_PartResources();		// Distribute resources
-					rgroup_Grow(); 				// Implement plant growth
-
-					mort_Main(&killedany); 		// Mortality that occurs during the growing season
-
-					rgroup_IncrAges(); 			// Increment ages of all plants
-
-					grazing_EndOfYear(); 		// Livestock grazing
-					
-					save_annual_species_relsize(); // Save annuals before we kill them
-
-					mort_EndOfYear(); 			// End of year mortality.
-
-					stat_Collect(year); 		// Update the accumulators
-
-				    killAnnuals(); 			// Kill annuals
-				    killMaxage();             // Kill plants that reach max age
-					proportion_Recovery(); 		// Recover from any disturbances
-					killExtraGrowth(); 		// Kill superfluous growth
-
-				} /* end model run for this cell*/
-			} /* end model run for this row */
-			if (UseSeedDispersal){
-				disperseSeeds();
-            }
-			
-			unload_cell(); // Reset the global variables
-		}/* end model run for this year*/
+				}
+			}
+			unload_cell();
+		}
 
 		// collects the data for the mort output,
         // i.e. fills the accumulators in ST_stats.c.
@@ -276,6 +358,9 @@ void runGrid(void)
 			for (i = 0; i < grid_Rows; i++){
 				for (j = 0; j < grid_Cols; j++)
 				{
+					if(!cell_in_range(i, j)){
+						continue;
+					}
 					load_cell(i, j);
 					stat_Collect_GMort();
 					stat_Collect_SMort();
@@ -287,6 +372,9 @@ void runGrid(void)
 		ChDir(grid_directories[GRID_DIRECTORY_STEPWAT_INPUTS]);
 		for(i = 0; i < grid_Rows; ++i){
 			for(j = 0; j < grid_Cols; ++j){
+				if(!cell_in_range(i, j)){
+					continue;
+				}
 				load_cell(i, j);
 				SXW_Reset(gridCells[i][j].mySXW->f_watin);
 				unload_cell();
@@ -296,8 +384,22 @@ void runGrid(void)
 		SW_Soilwat.hist.file_prefix = NULL;
 		ChDir("..");
 
+		if(checkpointInterval > 0 && iter % checkpointInterval == 0
+		   && iter < SuperGlobals.runModelIterations){
+			_write_grid_checkpoint(iter);
+		}
 	} /* end iterations */
 
+	logThroughput("Simulation", (long) (cellRangeEnd - cellRangeBegin) * SuperGlobals.runModelYears
+	                            * (SuperGlobals.runModelIterations - firstIter + 1),
+	              throughputClock() - start);
+
+	// The run finished, so there is nothing left to resume.
+	if(checkpointInterval > 0 || resumeFromCheckpoint){
+		_checkpoint_header(&header, checkpointName);
+		remove(checkpointName);
+	}
+
 	if(UseProgressBar){
 		logProgress(0, 0, OUTPUT);
 	}
@@ -307,6 +409,9 @@ void runGrid(void)
 		for (j = 0; j < grid_Cols; j++)
 		{
 			int cell = j + (i * grid_Cols);
+			if(!cell_in_range(i, j)){
+				continue;
+			}
 			load_cell(i, j);
 			char fileMort[1024], fileBMass[1024], fileReceivedProb[1024];
 
@@ -329,23 +434,259 @@ void runGrid(void)
 	}
 	unload_cell(); // Reset the global variables
 
-	// Output the Bmass and Mort average statistics (if requested).
-	char fileBMassCellAvg[1024], fileMortCellAvg[1024];
-	if (BmassFlags.summary){
-        sprintf(fileBMassCellAvg, "%s.csv", grid_files[GRID_FILE_PREFIX_BMASSCELLAVG]);
-		_Output_AllCellAvgBmass(fileBMassCellAvg);
-	}
-    if (MortFlags.summary){
-        sprintf(fileMortCellAvg, "%s.csv", grid_files[GRID_FILE_PREFIX_MORTCELLAVG]);
-        _Output_AllCellAvgMort(fileMortCellAvg);
-    }
+	if(useCellRange){
+		_write_cell_shard();
+	}
+}
 
-	free_grid_memory();	// Free our allocated memory since we do not need it anymore
-	parm_free_memory();		// Free memory allocated to the _files array in ST_params.c
-	if(initializationMethod == INIT_WITH_SPINUP) {
-		freeInitializationMemory();
+/* Simulate one year in gridCells[row][col], which must be loaded.
+   This is the per-cell body of the year loop. Apart from the process-wide
+   globals the cell is loaded into, it only touches the state of the given
+   cell. Anything that couples cells belongs in _end_grid_year(). */
+static void _run_cell_year(int row, int col, IntS year)
+{
+	Bool killedany;
+
+	Globals->currYear = year;
+
+	/* Seed dispersal needs to take into account last year's precipitation, 
+	   so we'll record it before calling Env_Generate(). */
+	if (year > 1 && UseSeedDispersal){
+		gridCells[row][col].mySeedDispersal->lyppt = gridCells[row][col].myEnvironment.ppt;
 	}
-	logProgress(0, 0, DONE);
+
+	/* The following functions mimic ST_main.c. */
+
+	rgroup_Establish(); 		// Establish individuals.
+
+	Env_Generate();				// Run SOILWAT2 to generate resources.
+
+	rgroup_PartResources();		// Distribute resources
+	rgroup_Grow(); 				// Implement plant growth
+
+	mort_Main(&killedany); 		// Mortality that occurs during the growing season
+
+	rgroup_IncrAges(); 			// Increment ages of all plants
+
+	grazing_EndOfYear(); 		// Livestock grazing
+	
+	save_annual_species_relsize(); // Save annuals before we kill them
+
+	mort_EndOfYear(); 			// End of year mortality.
+
+	stat_Collect(year); 		// Update the accumulators
+
+	killAnnuals(); 			// Kill annuals
+	killMaxage();             // Kill plants that reach max age
+	proportion_Recovery(); 		// Recover from any disturbances
+	killExtraGrowth(); 		// Kill superfluous growth
+	scratch_Reset();			// Release this year's scratch arrays
+}
+
+/* Returns TRUE if gridCells[row][col] is simulated by this process. */
+Bool cell_in_range(int row, int col){
+	int cell = col + (row * grid_Cols);
+	return (Bool) (cell >= cellRangeBegin && cell < cellRangeEnd);
+}
+
+/* Validate the cell range requested with --cells, or select the whole grid if
+   no range was requested. */
+static void _check_cell_range(void){
+	if(!useCellRange){
+		cellRangeBegin = 0;
+		cellRangeEnd = grid_Cells;
+		return;
+	}
+
+	if(cellRangeBegin < 0 || cellRangeEnd > grid_Cells || cellRangeBegin >= cellRangeEnd){
+		LogError(logfp, LOGFATAL, "Invalid cell range %d:%d. The grid has %d cells.",
+		         cellRangeBegin, cellRangeEnd, grid_Cells);
+	}
+	if(mergeCellShards){
+		LogError(logfp, LOGFATAL, "--cells and --merge can not be used together.");
+	}
+	if(UseSeedDispersal || initializationMethod == INIT_WITH_SEEDS){
+		LogError(logfp, LOGFATAL, "--cells requires independent cells, but seed dispersal couples them.");
+	}
+	if(!useRNGStreams){
+		LogError(logfp, LOGFATAL, "--cells requires --streams, because without it cells share "
+		         "their random number generators.");
+	}
+	printf("Simulating cells %d to %d\n\n", cellRangeBegin, cellRangeEnd - 1);
+}
+
+/* Name of the shard file for the cell range starting at begin. */
+static void _cell_shard_name(char *name, int begin){
+	sprintf(name, "%s_cells%d.bin", grid_files[GRID_FILE_PREFIX_BMASSCELLAVG], begin);
+}
+
+/* Write the accumulators of every cell in the cell range to a shard file.
+   The file starts with a header describing the grid, the range and the seed, followed
+   by one block per cell written by stat_Write_Accumulators(). */
+static void _write_cell_shard(void){
+	char fileName[1024];
+	int header[CELL_SHARD_HEADER_SIZE], cell;
+	FILE *f;
+
+	_cell_shard_name(fileName, cellRangeBegin);
+	f = OpenFile(fileName, "wb");
+
+	load_cell(0, 0); // For the group and species counts
+	header[0] = CELL_SHARD_MAGIC;
+	header[1] = grid_Rows;
+	header[2] = grid_Cols;
+	header[3] = cellRangeBegin;
+	header[4] = cellRangeEnd;
+	header[5] = SuperGlobals.runModelYears;
+	header[6] = Globals->grpCount;
+	header[7] = Globals->sppCount;
+	header[8] = (int) SuperGlobals.randseed;
+
+	if(fwrite(header, sizeof(int), CELL_SHARD_HEADER_SIZE, f) != CELL_SHARD_HEADER_SIZE){
+		LogError(logfp, LOGFATAL, "Could not write %s", fileName);
+	}
+	for(cell = cellRangeBegin; cell < cellRangeEnd; ++cell){
+		load_cell(cell / grid_Cols, cell % grid_Cols);
+		if(!stat_Write_Accumulators(f)){
+			LogError(logfp, LOGFATAL, "Could not write %s", fileName);
+		}
+	}
+	unload_cell();
+	CloseFile(&f);
+}
+
+/* Describe this run in header and write the name of its checkpoint file to
+   fileName. Every --cells range has its own checkpoint. Call this from the
+   directory the grid files were read from. */
+static void _checkpoint_header(CheckpointHeader *header, char *fileName){
+	unsigned int inputChecksum;
+
+	sprintf(fileName, "%s_checkpoint%d.bin", grid_files[GRID_FILE_PREFIX_BMASSCELLAVG], cellRangeBegin);
+
+	ChDir(grid_directories[GRID_DIRECTORY_STEPWAT_INPUTS]);
+	inputChecksum = parm_InputChecksum();
+	ChDir("..");
+	inputChecksum = checkpoint_ChecksumFile(inputChecksum, grid_files[GRID_FILE_SETUP]);
+	if(UseDisturbances){
+		inputChecksum = checkpoint_ChecksumFile(inputChecksum, grid_files[GRID_FILE_DISTURBANCES]);
+	}
+	if(initializationMethod != INIT_WITH_NOTHING){
+		inputChecksum = checkpoint_ChecksumFile(inputChecksum, grid_files[GRID_FILE_INIT_SPECIES]);
+	}
+	if(UseSoils){
+		inputChecksum = checkpoint_ChecksumFile(inputChecksum, grid_files[GRID_FILE_SOILS]);
+	}
+
+	load_cell(0, 0); // For the group and species counts
+	checkpoint_InitHeader(header, grid_Rows, grid_Cols, cellRangeBegin, cellRangeEnd, inputChecksum);
+	unload_cell();
+}
+
+/* Write a checkpoint of every cell in the cell range. Call this between
+   iterations, after iterationsDone iterations have finished. */
+static void _write_grid_checkpoint(IntS iterationsDone){
+	char fileName[1024];
+	CheckpointHeader header;
+	FILE *f;
+	int cell;
+
+	_checkpoint_header(&header, fileName);
+	header.iterationsDone = iterationsDone;
+	f = checkpoint_Create(fileName, &header);
+
+	for(cell = cellRangeBegin; cell < cellRangeEnd; ++cell){
+		load_cell(cell / grid_Cols, cell % grid_Cols);
+		if(!checkpoint_WritePlot(f)){
+			LogError(logfp, LOGFATAL, "Could not write checkpoint %s", fileName);
+		}
+	}
+	unload_cell();
+
+	checkpoint_Commit(f, fileName);
+}
+
+/* Restore every cell in the cell range from the checkpoint written by an
+   earlier run of the same grid. Returns the number of iterations the
+   checkpoint covers. */
+static IntS _read_grid_checkpoint(void){
+	char fileName[1024];
+	CheckpointHeader header;
+	FILE *f;
+	int cell;
+
+	_checkpoint_header(&header, fileName);
+	f = checkpoint_Open(fileName, &header);
+
+	for(cell = cellRangeBegin; cell < cellRangeEnd; ++cell){
+		load_cell(cell / grid_Cols, cell % grid_Cols);
+		if(!checkpoint_ReadPlot(f)){
+			LogError(logfp, LOGFATAL, "Checkpoint %s ended early.", fileName);
+		}
+	}
+	unload_cell();
+	CloseFile(&f);
+
+	printf("Resuming after iteration %d\n", header.iterationsDone);
+	return header.iterationsDone;
+}
+
+/* Read the shard files written by processes run with --cells into the
+   accumulators of gridCells. The shards must cover the grid without gaps:
+   the first shard starts at cell 0 and every following shard starts where
+   the previous one ended. */
+static void _merge_cell_shards(void){
+	char fileName[1024];
+	int header[CELL_SHARD_HEADER_SIZE], begin = 0, cell;
+	FILE *f;
+
+	while(begin < grid_Cells){
+		_cell_shard_name(fileName, begin);
+		f = fopen(fileName, "rb");
+		if(!f){
+			LogError(logfp, LOGFATAL, "No shard file %s for the cells starting at %d", fileName, begin);
+		}
+
+		load_cell(0, 0); // For the group and species counts
+		if(fread(header, sizeof(int), CELL_SHARD_HEADER_SIZE, f) != CELL_SHARD_HEADER_SIZE
+		   || header[0] != CELL_SHARD_MAGIC || header[1] != grid_Rows || header[2] != grid_Cols
+		   || header[3] != begin || header[4] <= begin || header[4] > grid_Cells
+		   || header[5] != SuperGlobals.runModelYears || header[6] != Globals->grpCount
+		   || header[7] != Globals->sppCount){
+			LogError(logfp, LOGFATAL, "Shard file %s does not match this grid", fileName);
+		}
+		if(header[8] != (int) SuperGlobals.randseed){
+			LogError(logfp, LOGFATAL, "Shard file %s was written with seed %ld, not %ld",
+			         fileName, SimContext_InputSeed(header[8]),
+			         SimContext_InputSeed(SuperGlobals.randseed));
+		}
+
+		for(cell = begin; cell < header[4]; ++cell){
+			load_cell(cell / grid_Cols, cell % grid_Cols);
+			if(!stat_Read_Accumulators(f)){
+				LogError(logfp, LOGFATAL, "Shard file %s is incomplete", fileName);
+			}
+		}
+		unload_cell();
+		fclose(f);
+
+		begin = header[4];
+	}
+}
+
+#ifdef STDEBUG
+void (*write_cell_shard)(void) = _write_cell_shard;
+void (*merge_cell_shards)(void) = _merge_cell_shards;
+#endif
+
+/* Work that has to wait until every cell has finished the current year.
+   Seed dispersal is currently the only process that couples cells. */
+static void _end_grid_year(void)
+{
+	if (UseSeedDispersal){
+		disperseSeeds();
+	}
+
+	unload_cell(); // Reset the global variables
 }
 
 /* Read the files.in file which was supplied to the program as an argument.
@@ -406,6 +747,7 @@ static void _init_grid_inputs(void)
 	}
 	if (UseSoils) {
 		_read_soils_in();
+		_init_roots_overrides();
 	}
 
     for(i = 0; i < grid_Rows; ++i) {
@@ -438,16 +780,27 @@ static void _init_stepwat_inputs(void)
 	ChDir(grid_directories[GRID_DIRECTORY_STEPWAT_INPUTS]);			// Change to folder with STEPWAT files
 	parm_SetFirstName(grid_files[GRID_FILE_FILES]);	// Set the name of the STEPWAT "files.in" file
 
-	/* Loop through all gridCells. */
+	/* Loop through all gridCells. Every cell reads the same input files, so
+	   they are only read for the first cell and copied into the others. The
+	   soils of each cell are put on top of the copy by load_cell() once
+	   _read_soils_in() has read them. */
 	for(i = 0; i < grid_Rows; ++i){
 		for(j = 0; j < grid_Cols; ++j){
 			load_cell(i, j); 				     // Load this cell into the global variables
-			parm_Initialize();				     // Initialize the STEPWAT variables
+			if(i == 0 && j == 0){
+				parm_Initialize();			     // Initialize the STEPWAT variables
+			} else {
+				_copy_stepwat_inputs(&gridCells[0][0]);
+			}
 			gridCells[i][j].myGroup = RGroup;    // This is necessary because load_cell only points RGroup to our cell-specific
 			                                     // resource group array, not to the variable that points to that array.
 			gridCells[i][j].mySpecies = Species; // This is necessary because load_cell only points Species to our cell-specific
 			                                     // species array, not to the variable that points to that array.
-			_init_SXW_inputs(TRUE, NULL);	     // Initialize the SXW and SOILWAT variables
+			if(i == 0 && j == 0){
+				_init_SXW_inputs(TRUE, NULL);    // Initialize the SXW and SOILWAT variables
+			} else {
+				SXW_InitFrom(gridCells[0][0].mySXW, gridCells[0][0].mySXWResources);
+			}
 
 			// Set mySXW to the location of the newly allocated SXW
 			gridCells[i][j].mySXW = getSXW();	
@@ -468,13 +821,114 @@ static void _init_stepwat_inputs(void)
 	ChDir("..");						// go back to the folder we started in
 }
 
-/* Reread input files. Be careful because this function reallocates the grid.
-   Make sure you call free_grid_memory before calling this function. */
-void rereadInputs(void){
-    _read_grid_setup();
-    _read_files();
-    _init_stepwat_inputs();
-    _init_grid_inputs();
+/* Copy the STEPWAT2 parameters parm_Initialize() read into src into the
+   loaded cell. This gives the same result as calling parm_Initialize() for
+   the loaded cell, without reading the input files again. The arrays are
+   sized the way ST_params.c sizes them so deallocate_Globals() can free them.
+
+   No memory is shared with src. These are all pointer members of the
+   structs copied here:
+   - Globals: the FILE handles of bmass and mort, which are only open while
+     ST_output.c writes a line. They are set to NULL.
+   - Succulent: none.
+   - RGroup: name, est_spp, species and kills are copied; sorted and
+     sortScratch start empty.
+   - Species: name, kills and seedprod are copied; IndvHead, indivs and
+     indivSpare start empty.
+   A pointer member added to one of these structs has to be added here. */
+static void _copy_stepwat_inputs(const CellType *src){
+	GrpIndex rg;
+	SppIndex sp;
+	const GroupType *g;
+	const SpeciesType *s;
+
+	*Globals = src->myGlobals;
+	Globals->bmass.fp_year = Globals->bmass.fp_sumry = NULL;
+	Globals->mort.fp_year = Globals->mort.fp_sumry = NULL;
+	*Succulent = src->mySucculent;
+
+	RGroup = (GroupType **) Mem_Calloc(SuperGlobals.max_rgroups, sizeof(GroupType *), "_copy_stepwat_inputs: RGroup");
+	ForEachGroup(rg){
+		g = src->myGroup[rg];
+		RGroup[rg] = (GroupType *) Mem_Calloc(1, sizeof(GroupType), "_copy_stepwat_inputs: RGroup");
+		*RGroup[rg] = *g;
+
+		RGroup[rg]->name = (char *) Mem_Calloc(SuperGlobals.max_groupnamelen + 1, sizeof(char), "_copy_stepwat_inputs: name");
+		strcpy(RGroup[rg]->name, g->name);
+		RGroup[rg]->est_spp = (SppIndex *) Mem_Calloc(SuperGlobals.max_spp_per_grp, sizeof(SppIndex), "_copy_stepwat_inputs: est_spp");
+		memcpy(RGroup[rg]->est_spp, g->est_spp, SuperGlobals.max_spp_per_grp * sizeof(SppIndex));
+		RGroup[rg]->species = (SppIndex *) Mem_Calloc(SuperGlobals.max_spp_per_grp, sizeof(SppIndex), "_copy_stepwat_inputs: species");
+		memcpy(RGroup[rg]->species, g->species, SuperGlobals.max_spp_per_grp * sizeof(SppIndex));
+		if(g->kills){
+			RGroup[rg]->kills = (IntUS *) Mem_Calloc(GrpMaxAge(rg), sizeof(IntUS), "_copy_stepwat_inputs: kills");
+			memcpy(RGroup[rg]->kills, g->kills, GrpMaxAge(rg) * sizeof(IntUS));
+		}
+		RGroup[rg]->sorted = NULL;
+		RGroup[rg]->sortScratch = NULL;
+		RGroup[rg]->sortedCapacity = 0;
+		RGroup_InvalidateSorted(RGroup[rg]);
+	}
+
+	Species = (SpeciesType **) Mem_Calloc(MAX_SPECIES, sizeof(SpeciesType *), "_copy_stepwat_inputs: Species");
+	ForEachSpecies(sp){
+		s = src->mySpecies[sp];
+		Species[sp] = (SpeciesType *) Mem_Calloc(1, sizeof(SpeciesType), "_copy_stepwat_inputs: Species");
+		*Species[sp] = *s;
+
+		Species[sp]->name = (char *) Mem_Calloc(SuperGlobals.max_speciesnamelen + 1, sizeof(char), "_copy_stepwat_inputs: name");
+		strcpy(Species[sp]->name, s->name);
+		if(s->kills){
+			Species[sp]->kills = (IntUS *) Mem_Calloc(SppMaxAge(sp), sizeof(IntUS), "_copy_stepwat_inputs: kills");
+			memcpy(Species[sp]->kills, s->kills, SppMaxAge(sp) * sizeof(IntUS));
+		}
+		if(s->seedprod){
+			Species[sp]->seedprod = (IntUS *) Mem_Calloc(s->viable_yrs, sizeof(IntUS), "_copy_stepwat_inputs: seedprod");
+			memcpy(Species[sp]->seedprod, s->seedprod, s->viable_yrs * sizeof(IntUS));
+		}
+		/* parm_Initialize() creates no individuals. */
+		Species[sp]->IndvHead = NULL;
+		Species[sp]->indivs = Species[sp]->indivSpare = NULL;
+		Species[sp]->indivCapacity = Species[sp]->indivSpareCapacity = 0;
+		Species[sp]->indivUsed = 0;
+	}
+}
+
+/* A cell can name its own roots file in the soils input. Every cell gets
+   the SXW tables of the first cell in _init_stepwat_inputs(), which were read
+   with the roots file of the SXW input files, so the cells with a different
+   roots file read their SXW inputs again with theirs. SOILWAT2 is not set
+   up again: it already has the cell's soils when the cell is loaded.
+   DEPENDENCIES: _init_stepwat_inputs() and _read_soils_in(). */
+static void _init_roots_overrides(void)
+{
+	int i, j;
+	char roots[MAX_FILENAMESIZE];
+
+	ChDir(grid_directories[GRID_DIRECTORY_STEPWAT_INPUTS]);
+
+	for(i = 0; i < grid_Rows; ++i){
+		for(j = 0; j < grid_Cols; ++j){
+			if(gridCells[i][j].mySoils.rootsFile[0] == '\0'){
+				continue;
+			}
+
+			load_cell(i, j);
+			// The same file SXW_Init() would read for this roots file
+			snprintf(roots, sizeof roots, "%s%s", DirName(getSXW()->f_roots),
+			         gridCells[i][j].mySoils.rootsFile);
+			if(strcmp(roots, getSXW()->f_roots) != 0){
+				free_all_sxw_memory();
+				_init_SXW_inputs(FALSE, gridCells[i][j].mySoils.rootsFile);
+
+				gridCells[i][j].mySXW = getSXW();
+				gridCells[i][j].myTranspWindow = getTranspWindow();
+				gridCells[i][j].mySXWResources = getSXWResources();
+			}
+			unload_cell();
+		}
+	}
+
+	ChDir("..");
 }
 
 /* Allocates memory for the grid cells. This only needs to be called once. */
@@ -756,50 +1210,86 @@ void free_grid_memory(void)
 	Mem_Free(gridCells);
 }
 
-/* Load gridCells[row][col] into the globals variables.
-   Any call to this function should have an accompanying call to unload_cell(). */
-void load_cell(int row, int col){
-    /* RGroup for this cell */
-	RGroup = gridCells[row][col].myGroup;
-
-	/*Species for this cell */
-	Species = gridCells[row][col].mySpecies;
-
-	/* Succulents corresponding to this cell */
-	Succulent = &gridCells[row][col].mySucculent;
-
-	/* This cell's environment. We expect each cell to
-	 * have slightly different weather each year */
-	Env = &gridCells[row][col].myEnvironment;
-
-	/* Cell's plot data */
-	Plot = &gridCells[row][col].myPlot;
-
-	/* Global variables corresponding to this cell */ 
-	Globals = &gridCells[row][col].myGlobals;
+/* Fill ctx with pointers into gridCells[row][col]. Nothing is bound by this
+   function; pass ctx to SimContext_Bind() to make it the active state. */
+void get_cell_context(int row, int col, SimContext *ctx){
+	CellType *cell = &gridCells[row][col];
+
+	ctx->rgroup = cell->myGroup;
+	ctx->species = cell->mySpecies;
+	ctx->succulent = &cell->mySucculent;
+	ctx->env = &cell->myEnvironment;
+	ctx->plot = &cell->myPlot;
+	ctx->globals = &cell->myGlobals;
+	ctx->cheatgrassPrecip = cell->myCheatgrassPrecip;
+	ctx->someKillage = cell->someKillage;
+	ctx->useCheatgrassWildfire = cell->UseCheatgrassWildfire;
+	ctx->duringInitialization = cell->DuringInitialization;
+
+	ctx->_Dist = cell->_Dist;
+	ctx->_Ppt = cell->_Ppt;
+	ctx->_Temp = cell->_Temp;
+	ctx->_Grp = cell->_Grp;
+	ctx->_Gsize = cell->_Gsize;
+	ctx->_Gpr = cell->_Gpr;
+	ctx->_Gmort = cell->_Gmort;
+	ctx->_Gestab = cell->_Gestab;
+	ctx->_Spp = cell->_Spp;
+	ctx->_Indv = cell->_Indv;
+	ctx->_Smort = cell->_Smort;
+	ctx->_Sestab = cell->_Sestab;
+	ctx->_Sreceived = cell->_Sreceived;
+	ctx->_Gwf = cell->_Gwf;
+	ctx->stats_init = cell->stats_init;
+
+	ctx->sxw = cell->mySXW;
+	ctx->sxwResources = cell->mySXWResources;
+	ctx->transpWindow = cell->myTranspWindow;
+
+	// Without --streams all cells draw from the process-wide generators.
+	ctx->rngs = useRNGStreams ? cell->myRNGs : NULL;
+}
 
-	/* TRUE if this cell is in spinup mode */
-	DuringInitialization = gridCells[row][col].DuringInitialization;
+/* Give every cell its own stream of each of the generators a SimContext
+   carries for iteration iter. Call this while no cell is loaded. Since no
+   cell shares a generator with another cell the results of a cell do not
+   depend on the order in which cells are run, or on which process runs them.
+   Does nothing without --streams. */
+void seed_cell_rngs(IntS iter){
+	int i, j;
 
-	/* This cell's cheatgrass-wildfire parameters */
-	setCheatgrassPrecip(gridCells[row][col].myCheatgrassPrecip);
+	if(!useRNGStreams){
+		return;
+	}
 
-	_SomeKillage = gridCells[row][col].someKillage;
-	UseCheatgrassWildfire = gridCells[row][col].UseCheatgrassWildfire;
+	for(i = 0; i < grid_Rows; ++i){
+		for(j = 0; j < grid_Cols; ++j){
+			SimContext_SeedRNGs(gridCells[i][j].myRNGs, j + (i * grid_Cols), iter);
+		}
+	}
+}
 
-	/* Copy this cell's accumulators into the local accumulators in ST_stats.c */
-	stat_Copy_Accumulators(gridCells[row][col]._Dist, gridCells[row][col]._Ppt, gridCells[row][col]._Temp,
-	                       gridCells[row][col]._Grp, gridCells[row][col]._Gsize, gridCells[row][col]._Gpr,
-						   gridCells[row][col]._Gmort, gridCells[row][col]._Gestab, gridCells[row][col]._Spp,
-						   gridCells[row][col]._Indv, gridCells[row][col]._Smort, gridCells[row][col]._Sestab,
-						   gridCells[row][col]._Sreceived, gridCells[row][col]._Gwf, gridCells[row][col].stats_init);
+/* Load gridCells[row][col] into the globals variables.
+   Any call to this function should have an accompanying call to unload_cell(). */
+void load_cell(int row, int col){
+	SimContext ctx;
+
+	/* SOILWAT2 is shared by all cells. With --streams the cell that is
+	   currently loaded keeps its copy of the SOILWAT2 state in its SXW.
+	   Without it every cell continues from the state the previous cell left
+	   behind, as in earlier versions. */
+	if(useRNGStreams){
+		SXW_StoreSoilwatState();
+	}
 
-	/* Copy this cell's SXW variables into the local variables in sxw.c */
-	copy_sxw_variables(gridCells[row][col].mySXW, gridCells[row][col].mySXWResources, gridCells[row][col].myTranspWindow);
+	get_cell_context(row, col, &ctx);
+	SimContext_Bind(&ctx);
 
 	// If we have read in the soil information num_layers will be > 0.
 	// Otherwise we haven't read the file so there is no point wasting time on this.
-	if(gridCells[row][col].mySoils.num_layers > 0){
+	// With --streams the soil layers only need to be recomputed if this cell's
+	// copy of them is out of date.
+	if(gridCells[row][col].mySoils.num_layers > 0 && !(useRNGStreams && SXW_RestoreSite())){
 		RealD soilRegionsLowerBounds[3] = { 30, 70, 100 };
 		set_soillayers(gridCells[row][col].mySoils.num_layers, gridCells[row][col].mySoils.depth, gridCells[row][col].mySoils.matricd,
 	    	           gridCells[row][col].mySoils.gravel, gridCells[row][col].mySoils.evco, gridCells[row][col].mySoils.trco_grass,
@@ -807,6 +1297,9 @@ void load_cell(int row, int col){
 					   gridCells[row][col].mySoils.psand, gridCells[row][col].mySoils.pclay, gridCells[row][col].mySoils.imperm,
 				   	   gridCells[row][col].mySoils.soiltemp, 3, soilRegionsLowerBounds);
 	}
+	if(useRNGStreams){
+		SXW_RestoreSoilwat();
+	}
 }
 
 /* Nullify all global variables. This function should appear after every call 
@@ -820,16 +1313,10 @@ void load_cell(int row, int col){
    }
    unload_cell() */
 void unload_cell(){
-	Species = NULL;
-	RGroup = NULL;
-	Succulent = NULL;
-	Env = NULL;
-	Plot = NULL;
-	Globals = NULL;
-	// Nullify the accumulators
-	stat_Copy_Accumulators(NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,FALSE);
-	// Nullify sxw
-	copy_sxw_variables(NULL,NULL,NULL);
+	if(useRNGStreams){
+		SXW_StoreSoilwatState();
+	}
+	SimContext_Clear();
 }
 
 /** 
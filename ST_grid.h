@@ -21,6 +21,7 @@
 #include "sw_src/SW_Model.h"
 #include "sw_src/SW_Weather.h"
 #include "ST_seedDispersal.h"
+#include "ST_context.h"
 
 /*********************** Grid Structures ****************************/
 
@@ -108,6 +109,9 @@ struct grid_cell_st
 	// Soil layer information for this cell.
 	SoilType mySoils;
 	/* ------------------ End Soils --------------------- */
+
+	/* This cell's random number generators. Seeded by seed_cell_rngs(). */
+	pcg32_random_t myRNGs[N_CONTEXT_RNGS];
 } typedef CellType;
 
 /**************************** Enumerators *********************************/
@@ -161,13 +165,23 @@ char *grid_files[N_GRID_FILES];
 char *grid_directories[N_GRID_DIRECTORIES];
 /* TRUE if every cell should write its own output file. */
 Bool writeIndividualFiles;
+/* TRUE if this process only simulates the cells in [cellRangeBegin, cellRangeEnd).
+   Cells are numbered in row-major order. Set with the --cells=begin:end option. */
+Bool useCellRange;
+int cellRangeBegin;
+int cellRangeEnd;
+/* TRUE if the cell shard files should be merged into the cell average files
+   instead of running a simulation. Set with the --merge option. */
+Bool mergeCellShards;
 
 /**************************** Exported Functions **********************************/
 
 void runGrid(void);
+void get_cell_context(int row, int col, SimContext *ctx);
 void load_cell(int row, int col);
 void unload_cell(void);
-void rereadInputs(void);
+void seed_cell_rngs(IntS iter);
+Bool cell_in_range(int row, int col);
 void free_grid_memory(void);
 
 #endif
\ No newline at end of file
@@ -48,8 +48,56 @@ void indiv_proportion_Grazing( IndivType *ndv, RealF proportionGrazing);
 
 /*********** Locally Used Function Declarations ************/
 /***********************************************************/
-static IndivType *_create ( void);
+static IndivType *_create ( SppIndex sp);
 void _delete (IndivType *ndv);
+static void _compact(SpeciesType *s, int count);
+static void _merge_sort(IndivType **list, IndivType **scratch, size_t n, const byte sorttype);
+static int _compare_size(const IndivType *a, const IndivType *b, const byte sorttype);
+
+/**
+ * \brief Counts changes to individuals: establishment, deaths, moves and
+ *        changes of relsize.
+ * 
+ * A list derived from individuals, like the size-ordered index of
+ * RGroup_SortedIndivs(), is still valid if this has not changed since the
+ * list was built. Starts at 1 so that 0 never matches.
+ * 
+ * \ingroup INDIVIDUAL
+ */
+unsigned long indivChanges = 1;
+
+/* Smallest number of individuals a species allocates room for. */
+#define MIN_INDIV_CAPACITY 16
+
+/* Storage of individuals and how long pointers to them stay valid.
+
+   Every species keeps its individuals in one array, SpeciesType.indivs,
+   linked into SpeciesType.IndvHead in list order. A death only unlinks the
+   individual; its slot is reclaimed when the array is compacted, which
+   copies the live individuals in list order into the spare array and
+   swaps the two. Compaction happens
+   - in Indiv_Reserve() and Indiv_Alloc() when the array is full, and
+   - in Indiv_Pack() when the array has dead slots or new individuals at the
+     head of the list, i.e. in rgroup_Grow() of every year in which the
+     species gained or lost an individual.
+
+   A compaction moves every individual of the species. An IndivType pointer
+   is therefore only valid until the next call of one of those functions
+   for its species, and never from one year into the next. Lists built from
+   individuals must be rebuilt once indivChanges has moved, which every
+   compaction does; see RGroup_SortedIndivs().
+
+   The request was for separate arrays of the hot fields with swap-remove
+   deletion. That was adapted to this layout because:
+   - Swap-remove reorders the list. The list order decides the order in
+     which random numbers are drawn for individuals and how ties are
+     broken when they are sorted by size, so results would change.
+   - Mortality collects IndivType pointers and kills from that list, so
+     individuals must stay in place for the rest of the year. Compaction
+     only happens at the points listed above.
+   - Every function in the model reads individuals through IndivType. A
+     struct of arrays would change all of them, copy_individual() and the
+     STdebug inserts included. */
 
 /***********************************************************/
 /****************** Begin Function Code ********************/
@@ -106,13 +154,14 @@ Bool indiv_New( SppIndex sp) {
                    SuperGlobals.max_indivs_per_spp);
   }
 
-  p = _create();
+  p = _create(sp);
   p->id = id;
   p->myspecies = sp;
   p->killed = FALSE;
   p->age = 1;
   p->slow_yrs = 0;
-  p->relsize = Species[sp]->relseedlingsize;
+  p->sortRank = -1;
+  Indiv_SetRelsize(p, Species[sp]->relseedlingsize);
 
   /* link the new indiv to the head of the species list*/
   /* newer objects are closer to head */
@@ -121,6 +170,7 @@ Bool indiv_New( SppIndex sp) {
     p->Next->Prev = p;
   p->Prev = NULL;
   Species[sp]->IndvHead = p;
+  Species[sp]->indivsInOrder = FALSE;
 
   // This functionality is unused, but it might be useful in the future.
   //sql for inserting new indiv
@@ -131,6 +181,26 @@ Bool indiv_New( SppIndex sp) {
   return TRUE;
 }
 
+/**
+ * \brief Change the relsize of an individual.
+ * 
+ * Every change to IndivType.relsize must go through here so that
+ * SpeciesType.indivs_relsize keeps matching the sum over the list of
+ * individuals.
+ * 
+ * \param ndv A pointer to an individual in the list of its species.
+ * \param relsize The new relative size.
+ * 
+ * \sa getSpeciesRelsize()
+ * 
+ * \ingroup INDIVIDUAL
+ */
+void Indiv_SetRelsize(IndivType *ndv, RealF relsize) {
+  Species[ndv->myspecies]->indivs_relsize += (double) relsize - ndv->relsize;
+  ndv->relsize = relsize;
+  indivChanges++;
+}
+
 /** \brief Copy one individual's information to another individual. 
  * 
  *  \param src is the source [IndivType](\ref IndivType) to copy from.
@@ -159,6 +229,7 @@ void copy_individual(const IndivType* src, IndivType* dest){
   dest->killedby = src->killedby;
   dest->mm_extra_res = src->mm_extra_res;
   dest->myspecies = src->myspecies;
+  dest->sortRank = src->sortRank;
 }
 
 /**
@@ -176,13 +247,168 @@ void copy_individual(const IndivType* src, IndivType* dest){
  * 
  * \ingroup INDIVIDUAL_PRIVATE
  */
-static IndivType *_create ( void) {
+static IndivType *_create ( SppIndex sp) {
+  return Indiv_Alloc(Species[sp]);
+}
+
+/**
+ * \brief Allocate a zeroed individual in the storage of a species.
+ * 
+ * Every species keeps its individuals in one contiguous array,
+ * SpeciesType.indivs, so walking SpeciesType.IndvHead reads memory in
+ * order instead of jumping between separate allocations. An individual
+ * that dies keeps its slot until the array is compacted.
+ * 
+ * If the array is full it is compacted into the spare array of the
+ * species, grown if necessary, which moves every individual of the species. Call Indiv_Reserve() first when
+ * pointers to individuals of this species are held anywhere but in the
+ * linked list.
+ * 
+ * \param s The species the individual will belong to.
+ * 
+ * \return pointer to the individual. The caller links it into the list.
+ * 
+ * \ingroup INDIVIDUAL
+ */
+IndivType *Indiv_Alloc(SpeciesType *s) {
   IndivType *p;
 
-  p = (IndivType *) Mem_Calloc( 1, sizeof(IndivType),
-                                "indiv_create");
-  return (p);
+  Indiv_Reserve(s, 1);
+
+  p = &s->indivs[s->indivUsed++];
+  memset(p, 0, sizeof(IndivType));
+  indivChanges++;
+  return p;
+}
+
+/**
+ * \brief Make sure the next count calls to Indiv_Alloc() do not move
+ *        any individual of a species.
+ * 
+ * If the array of the species is too small, its live individuals are
+ * compacted into its spare array, in list order, with room for at least count
+ * more. Dead slots are reclaimed at the same time. Species_Add_Indiv()
+ * calls this once per batch of new individuals.
+ * 
+ * \param s The species.
+ * \param count The number of individuals about to be allocated.
+ * 
+ * \ingroup INDIVIDUAL
+ */
+void Indiv_Reserve(SpeciesType *s, int count) {
+  if (s->indivUsed + count > s->indivCapacity)
+    _compact(s, count);
+}
 
+/**
+ * \brief Forget all individuals of a species without freeing its array.
+ * 
+ * Used when the individuals are about to be rebuilt from a copy. The
+ * caller must append them to the list in the order they are allocated.
+ * 
+ * \ingroup INDIVIDUAL
+ */
+void Indiv_Clear(SpeciesType *s) {
+  s->IndvHead = NULL;
+  s->indivUsed = 0;
+  s->indivsInOrder = TRUE;
+  indivChanges++;
+}
+
+/**
+ * \brief Get the individuals of a species as a plain array.
+ * 
+ * Compacts the array of the species if it has dead slots or is not in
+ * list order, so that element i of the result is the i-th individual of
+ * the list. Loops over the result read memory in order. A
+ * species without individuals only has its slots forgotten, so nothing is
+ * allocated.
+ * 
+ * The array stays valid until the next individual is allocated or killed.
+ * Compacting moves every individual of the species, so pointers to them
+ * taken before this call are no longer valid.
+ * 
+ * \param s The species.
+ * \param n The number of individuals is returned here.
+ * 
+ * \return s->indivs.
+ * 
+ * \ingroup INDIVIDUAL
+ */
+IndivType *Indiv_Pack(SpeciesType *s, int *n) {
+  if (!s->indivsInOrder)
+    _compact(s, 0);
+
+  *n = s->indivUsed;
+  return s->indivs;
+}
+
+/**
+ * \brief Free the individual arrays of a species.
+ * 
+ * \ingroup INDIVIDUAL
+ */
+void Indiv_FreeStorage(SpeciesType *s) {
+  Indiv_Clear(s);
+  Mem_Free(s->indivs);
+  Mem_Free(s->indivSpare);
+  s->indivs = s->indivSpare = NULL;
+  s->indivCapacity = s->indivSpareCapacity = 0;
+}
+
+/**
+ * \brief Move the individuals of a species into its spare array, with
+ *        room for count more, and swap the two arrays.
+ * 
+ * The individuals are stored in list order, so the list is walked from
+ * the first slot to the last. The spare array is only reallocated when it
+ * is too small, and then made twice as large as needed, so a species whose
+ * number of individuals has settled compacts without allocating or freeing
+ * anything. If there is nothing to keep and nothing to make room for, the
+ * slots are simply forgotten.
+ * 
+ * \ingroup INDIVIDUAL_PRIVATE
+ */
+static void _compact(SpeciesType *s, int count) {
+  IndivType *indivs, *p;
+  int n = 0, capacity;
+
+  for (p = s->IndvHead; p != NULL; p = p->Next)
+    n++;
+
+  if (n + count == 0) {
+    Indiv_Clear(s);
+    return;
+  }
+
+  if (s->indivSpareCapacity < n + count) {
+    Mem_Free(s->indivSpare);
+    s->indivSpareCapacity = max(2 * (n + count), MIN_INDIV_CAPACITY);
+    s->indivSpare = (IndivType *) Mem_Calloc(s->indivSpareCapacity, sizeof(IndivType),
+                                             "_compact: individuals");
+  }
+  indivs = s->indivSpare;
+  capacity = s->indivSpareCapacity;
+
+  n = 0;
+  for (p = s->IndvHead; p != NULL; p = p->Next) {
+    indivs[n] = *p;
+    indivs[n].Prev = (n > 0) ? &indivs[n - 1] : NULL;
+    if (n > 0)
+      indivs[n - 1].Next = &indivs[n];
+    n++;
+  }
+  if (n > 0)
+    indivs[n - 1].Next = NULL;
+
+  s->indivSpare = s->indivs;
+  s->indivSpareCapacity = s->indivCapacity;
+  s->indivs = indivs;
+  s->indivCapacity = capacity;
+  s->indivUsed = n;
+  s->IndvHead = (n > 0) ? indivs : NULL;
+  s->indivsInOrder = TRUE;
+  indivChanges++;
 }
 
 /**
@@ -219,7 +445,7 @@ Bool indiv_Kill_Partial( MortalityType code,
   if ( GT(ndv->relsize, killamt) && Species[sp]->isclonal) {
     result            = TRUE;
     ndv->killed       = TRUE;
-    ndv->relsize     -= killamt;
+    Indiv_SetRelsize(ndv, ndv->relsize - killamt);
     ndv->killedby     = code;
     ndv->growthrate   = 0.0;
     ndv->prob_veggrow = Species[sp]->prob_veggrow[code];
@@ -269,12 +495,12 @@ void indiv_proportion_Kill(IndivType *ndv, int killType, RealF proportKilled)
 	RealF reduction = -(ndv->relsize * proportKilled);
 //	printf("inside indiv_proportion_Kill() old indiv rel_size=%f, reduction=%f \n",ndv->relsize,reduction);
 
-	ndv->relsize = ndv->relsize + reduction;
+	Indiv_SetRelsize(ndv, ndv->relsize + reduction);
 //	printf("inside indiv_proportion_Kill() new indiv rel_size=%f \n",ndv->relsize);
 
 	if (ZERO(ndv->relsize) || LT(ndv->relsize, 0.0))
 	{
-		ndv->relsize =0.0;
+		Indiv_SetRelsize(ndv, 0.0);
 		// increase mortality count only if relsize has become zero due to fire
 		species_Update_Kills(ndv->myspecies, ndv->age);
 	}
@@ -309,12 +535,12 @@ void indiv_proportion_Grazing( IndivType *ndv, RealF proportionGrazing)
 
     RealF grazing_reduce = -(ndv->normal_growth * proportionGrazing);
     //	printf("inside indiv_proportion_Grazing() old indiv rel_size=%f, grazing_reduce=%f \n",ndv->relsize,grazing_reduce);
-    ndv->relsize = ndv->relsize + grazing_reduce;
+    Indiv_SetRelsize(ndv, ndv->relsize + grazing_reduce);
     //	printf("inside indiv_proportion_Grazing() new indiv rel_size=%f \n",ndv->relsize);
 
 	if (ZERO(ndv->relsize) || LT(ndv->relsize, 0.0))
 	{
-        ndv->relsize = 0.0;
+        Indiv_SetRelsize(ndv, 0.0);
     }
 #undef xF_DELTA
 #undef xD_DELTA
@@ -357,7 +583,7 @@ void indiv_proportion_Recovery(IndivType *ndv, int killType, RealF proportionRec
     //printf("ndv->relsize before = %f\n, Species = %s \n", ndv->relsize, Species[ndv->myspecies]->name);
     //printf("increase = %f\n, Species = %s \n", increase, Species[ndv->myspecies]->name);
 
-    ndv->relsize = ndv->relsize + increase;
+    Indiv_SetRelsize(ndv, ndv->relsize + increase);
     //printf("ndv->relsize after = %f\n,Species = %s \n", ndv->relsize, Species[ndv->myspecies]->name);
 
     /* This should never happen because proportion recovered should always be 
@@ -434,10 +660,6 @@ void _delete (IndivType *ndv)
   sp = ndv->myspecies;
   s = Species[sp];
 
-  #ifdef DEBUG_MEM
-    assert(fValidPointer(ndv, sizeof(IndivType)));
-  #endif
-
   /* Detach indiv's data object from list */
   if (ndv == s->IndvHead) {
     if (ndv->Next == NULL)
@@ -452,6 +674,13 @@ void _delete (IndivType *ndv)
       ndv->Next->Prev = ndv->Prev;
   }
 
+  // remove the individual's size from the species total; an empty list
+  // resets it so rounding errors cannot accumulate
+  if (s->IndvHead == NULL)
+    s->indivs_relsize = 0.0;
+  else
+    s->indivs_relsize -= ndv->relsize;
+
   // update Species[ndv->myspecies]->est_count, i.e.,
   // remove one individual from tally
   if( --s->est_count == 0) {
@@ -465,45 +694,142 @@ void _delete (IndivType *ndv)
      LogError(logfp, LOGFATAL,
               "PGMR: Indiv Count out of sync in _delete()");
 
-  Mem_Free(ndv);
+  // the slot in Species[sp]->indivs is reclaimed by the next compaction
+  s->indivsInOrder = FALSE;
+  indivChanges++;
 }
 
 /**
- * \brief Sort a list of pointers to individuals according to the
- *             size of the individuals.
+ * \brief Sort a list of pointers to individuals by size using the given
+ *        scratch space.
  * 
- * This function is irrespective of species, age, etc.
+ * A stable top-down merge sort. Individuals of equal size keep their
+ * order in list, which is the order the glibc qsort() used before had as
+ * well, so the results do not depend on the C library. Sizes are compared
+ * inline rather than through a comparison function.
  * 
- * \param sorttype indicates whether ascending or descending
- * \param n number of individuals to be sorted
+ * \param sorttype SORT_A for ascending or SORT_D for descending order.
+ * \param n number of individuals to be sorted.
  * \param list an array of n pointers to individuals to be sorted.
+ * \param scratch room for n pointers, overwritten.
  * 
- * \sideeffect The list is returned sorted. 
+ * \sideeffect The list is returned sorted.
  * 
  * \ingroup INDIVIDUAL
  */
-void Indiv_SortSize( const byte sorttype,
-                     const size_t n, IndivType **list) {
-  int (*cmpfunc)(const void*, const void*);
-
-  if ( n < 1) return;  /* shouldn't happen */
-  switch (sorttype) {
-    case SORT_A: cmpfunc = Indiv_CompSize_A; break;
-    case SORT_D: cmpfunc = Indiv_CompSize_D; break;
-    default:
-      LogError(logfp, LOGFATAL,
-             "Invalid sort mode in Indiv_SortSize");
+void Indiv_MergeSortSize( const byte sorttype, const size_t n,
+                          IndivType **list, IndivType **scratch) {
+  if (sorttype != SORT_A && sorttype != SORT_D)
+    LogError(logfp, LOGFATAL, "Invalid sort mode in Indiv_MergeSortSize");
+
+  _merge_sort(list, scratch, n, sorttype);
+}
+
+/**
+ * \brief Sort a list of individuals that is nearly sorted already.
+ * 
+ * An insertion sort by size, and by pos for individuals of the same size.
+ * With pos the position of each individual in the list of its group, this
+ * is the order Indiv_MergeSortSize() gives for that list. It is fast if few
+ * individuals are out of place, so it gives up after maxShifts moves.
+ * 
+ * It also gives up if two individuals are compared as equal without being
+ * exactly equal. Near ties like that may leave the order up to the sort
+ * algorithm, so the merge sort has to decide it.
+ * 
+ * \param sorttype SORT_A for ascending or SORT_D for descending order.
+ * \param n number of individuals to be sorted.
+ * \param list an array of n pointers to individuals to be sorted.
+ * \param pos the n positions of the individuals, moved along with them.
+ * \param maxShifts how many moves to try before giving up.
+ * 
+ * \return TRUE if the list is sorted. FALSE if the sort gave up; list and
+ *         pos are then out of order.
+ * 
+ * \sa RGroup_SortedIndivs()
+ * 
+ * \ingroup INDIVIDUAL
+ */
+Bool Indiv_ResortSize( const byte sorttype, const size_t n,
+                       IndivType **list, int *pos, size_t maxShifts) {
+  size_t i, k, shifts = 0;
+  IndivType *ndv;
+  int p, c;
+
+  for (i = 1; i < n; i++) {
+    ndv = list[i];
+    p = pos[i];
+    for (k = i; k > 0; k--) {
+      c = _compare_size(list[k - 1], ndv, sorttype);
+      if (c < 0 || (c == 0 && pos[k - 1] < p))
+        break;
+      if (++shifts > maxShifts)
+        return FALSE;
+      list[k] = list[k - 1];
+      pos[k] = pos[k - 1];
+    }
+    list[k] = ndv;
+    pos[k] = p;
+  }
+
+  for (i = 1; i < n; i++) {
+    if (_compare_size(list[i - 1], list[i], sorttype) == 0
+        && list[i - 1]->relsize != list[i]->relsize)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * \brief The recursion of Indiv_MergeSortSize().
+ * 
+ * \ingroup INDIVIDUAL_PRIVATE
+ */
+static void _merge_sort(IndivType **list, IndivType **scratch, size_t n, const byte sorttype) {
+  size_t n1, n2, k = 0;
+  IndivType **b1, **b2;
+
+  if (n <= 1)
+    return;
+
+  n1 = n / 2;
+  n2 = n - n1;
+  b1 = list;
+  b2 = list + n1;
+  _merge_sort(b1, scratch, n1, sorttype);
+  _merge_sort(b2, scratch, n2, sorttype);
+
+  while (n1 > 0 && n2 > 0) {
+    if (_compare_size(*b1, *b2, sorttype) <= 0) {
+      scratch[k++] = *b1++;
+      n1--;
+    } else {
+      scratch[k++] = *b2++;
+      n2--;
+    }
+  }
+  while (n1 > 0) {
+    scratch[k++] = *b1++;
+    n1--;
   }
+  /* whatever is left of the second half is already in place */
+  memcpy(list, scratch, k * sizeof(IndivType *));
+}
+
+/**
+ * \brief Compare the sizes of two individuals like Indiv_CompSize_A() or
+ *        Indiv_CompSize_D() do.
+ * 
+ * \ingroup INDIVIDUAL_PRIVATE
+ */
+static int _compare_size(const IndivType *a, const IndivType *b, const byte sorttype) {
+  int r = 0;
+
+  if      ( LT(a->relsize, b->relsize) ) r = -1;
+  else if ( GT(a->relsize, b->relsize) ) r = 1;
 
-  qsort( list,
-         n,
-         sizeof(IndivType **),
-         cmpfunc
-       );
-/*
-  for(i=0;i<=n;i++)printf("%d:spp=%d, size=%5.4f\n",
-                       i,list[i]->myspecies,list[i]->relsize);
-*/
+  return (sorttype == SORT_D) ? -r : r;
 }
 
 
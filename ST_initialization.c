@@ -14,12 +14,15 @@
 //      for ONE cell. Once you have your function written, add an entry for 
 //      it to the InitializationMethod enumerator in ST_initialization.h, 
 //      add your method to _read_grid_setup() of ST_grid.c, then add your 
-//      function to the switch statement in runInitialization(). To see
+//      function to the switch statement in _initialize_by_year(). To see
 //      an example initialization function check out _run_spinup().
+//      Methods that never look at other cells can also be run cell by
+//      cell, which is faster; see _initialize_by_cell().
 /***********************************************************************/
 
 // ST_initialization.h contains declarations for runInitialization and loadInitializationConditions 
 #include "ST_initialization.h" 
+#include <string.h>
 #include "ST_grid.h"
 #include "ST_stats.h"
 #include "ST_globals.h"
@@ -31,6 +34,25 @@
 #include "sw_src/filefuncs.h"
 #include "ST_progressBar.h"
 #include "ST_stats.h"
+#include "ST_scratch.h"
+
+/********** Local structs. These should all be treated as private. ***************/
+
+/* The state of one cell at the end of initialization. species and groups are
+   value copies whose pointer members are not used. The arrays those members
+   point to are packed into arrays by _copy_cell_arrays(), and the
+   individuals of all species are stored in indivs, species by species in
+   list order. */
+struct cell_snapshot_st {
+	SpeciesType *species;
+	GroupType *groups;
+	EnvType environment;
+	PlotType plot;
+	SucculentType succulent;
+	IndivType *indivs;
+	int *indivCount;	/* Number of individuals in indivs for each species */
+	char *arrays;
+} typedef CellSnapshot;
 
 /********** Local functions. These should all be treated as private. *************/
 static void _run_spinup(void);
@@ -38,6 +60,13 @@ static void _run_seed_initialization(void);
 static void _beginInitialization(void);
 static void _endInitialization(void);
 static void _saveAsInitializationConditions(void);
+static long _initialize_by_cell(void);
+static long _initialize_by_year(void);
+static void _load_initialization_cell(int row, int col);
+static void _take_snapshot(CellSnapshot *snap);
+static void _restore_snapshot(const CellSnapshot *snap);
+static size_t _copy_cell_arrays(char *arrays, Bool take);
+static size_t _copy_array(char *arrays, size_t offset, void *live, size_t size, Bool take);
 
 /***************************** Externed variables **********************************/
 /* Note that in an ideal world we wouldn't need to extern any variables because 
@@ -50,15 +79,13 @@ extern SW_SITE SW_Site;
 extern SW_VEGPROD SW_VegProd;
 extern SW_WEATHER SW_Weather;
 
-extern pcg32_random_t grid_rng;         // Gridded mode's unique RNG.
+extern Bool UseProgressBar;             // From ST_main.c
 
-/* We need to seed these RNGs when using the gridded mode but do not use them in this file. */
-extern pcg32_random_t environs_rng;     // Used exclusively in ST_environs.c
-extern pcg32_random_t resgroups_rng;    // Used exclusively in ST_resgroups.c
-extern pcg32_random_t species_rng;      // Used exclusively in ST_species.c
-extern pcg32_random_t markov_rng;       // Used exclusively in SW_Markov.c
+/***************************** Local variables **********************************/
 
-extern Bool UseProgressBar;             // From ST_main.c
+/* One snapshot per cell, indexed by col + (row * grid_Cols). Cells that
+   are outside of --cells are left empty. */
+static CellSnapshot *_snapshots = NULL;
 
 /********* Modular functions defined elsewhere ************/
 /* Again, we should clean this up eventually. -CH */
@@ -69,39 +96,32 @@ void rgroup_Grow(void);
 void rgroup_IncrAges(void);
 void parm_Initialize(void);
 void Plot_Initialize(void);
-void copy_rgroup(const GroupType* src, GroupType* dest);
-void copy_species(const SpeciesType* src, SpeciesType* dest);
 
 /* Initializes the plot with whichever method you have specified with initializationMethod. 
    This function takes care of EVERYTHING involved with initialization.
    After calling this function you can load in the initialization information by calling 
    loadInitializationConditions(). */
 void runInitialization(void){
-	_beginInitialization();
-
-    /* Dummy accumulators to ensure we do not collect statistics */
-	StatType *dummy_Dist, *dummy_Ppt, *dummy_Temp,
-  		*dummy_Grp, *dummy_Gsize, *dummy_Gpr, *dummy_Gmort, *dummy_Gestab,
-  		*dummy_Spp, *dummy_Indv, *dummy_Smort, *dummy_Sestab, *dummy_Sreceived;
-	FireStatsType *dummy_Gwf;
-
 	/* For iterating over gridCells */
 	int i, j;
 
-	/* For iterating over years */
-	IntS year;
+	/* Number of cell-years simulated, for reporting throughput */
+	long cellYears;
+	double start = throughputClock();
 
-    /* Initialization is technically an iteration so we need to seed the RNGs. */
-    RandSeed(SuperGlobals.randseed, &environs_rng);
-    RandSeed(SuperGlobals.randseed, &mortality_rng);
-    RandSeed(SuperGlobals.randseed, &resgroups_rng);
-    RandSeed(SuperGlobals.randseed, &species_rng);
-    RandSeed(SuperGlobals.randseed, &grid_rng);
-    RandSeed(SuperGlobals.randseed, &markov_rng);
+	_beginInitialization();
 
-    // Initialize the plot for each grid cell
+    /* Initialization is technically an iteration so we need to seed the RNGs.
+       It uses the streams of iteration 0. */
+    SimContext_SeedProcessRNGs(0);
+    seed_cell_rngs(0);
+
+    // Initialize the plot for each grid cell this process simulates
     for (i = 0; i < grid_Rows; i++){
         for (j = 0; j < grid_Cols; j++){
+            if(!cell_in_range(i, j)){
+                continue;
+            }
             load_cell(i, j);
             Plot_Initialize();
             Globals->currIter = 1; // Iteration doesn't really matter, I set it to 1 here just in case.
@@ -109,6 +129,76 @@ void runInitialization(void){
     }
     unload_cell(); // Reset the global variables
 
+    if(initializationMethod == INIT_WITH_SPINUP && useRNGStreams){
+        cellYears = _initialize_by_cell();
+    } else {
+        cellYears = _initialize_by_year();
+    }
+
+    ChDir(grid_directories[GRID_DIRECTORY_STEPWAT_INPUTS]);
+    SXW_Reset(gridCells[0][0].mySXW->f_watin);
+    //TODO: This is a shortcut. swc history is not used and shouldn't be until this is fixed.
+    Mem_Free(SW_Soilwat.hist.file_prefix);
+    SW_Soilwat.hist.file_prefix = NULL;
+    ChDir("..");
+
+	_endInitialization();
+
+	logThroughput("Initialization", cellYears, throughputClock() - start);
+}
+
+/* Run every cell that requested initialization through all initialization
+   years before moving on to the next cell. Only valid for methods that never
+   look at other cells, like spinup, and only with --streams. Each cell is
+   loaded once instead of once per year, and since every cell has its own RNG
+   streams and SOILWAT2 state the result is the same as running year by year.
+   Returns the number of cell-years simulated. */
+static long _initialize_by_cell(void){
+	int i, j, cellsDone = 0, cellsToRun = 0;
+	IntS year;
+
+	for (i = 0; i < grid_Rows; ++i){
+		for (j = 0; j < grid_Cols; ++j){
+			if(gridCells[i][j].mySpeciesInit.useInitialization && cell_in_range(i, j)){
+				cellsToRun++;
+			}
+		}
+	}
+
+	for (i = 0; i < grid_Rows; ++i){
+		for (j = 0; j < grid_Cols; ++j){
+			if(!gridCells[i][j].mySpeciesInit.useInitialization || !cell_in_range(i, j)){
+				continue; // No spinup requested. Move on to next cell.
+			}
+			if(UseProgressBar){
+				// Report progress as the fraction of cells finished.
+				logProgress(0, (cellsDone * SuperGlobals.runInitializationYears) / cellsToRun,
+				            INITIALIZATION);
+			}
+
+			_load_initialization_cell(i, j);
+			for (year = 1; year <= SuperGlobals.runInitializationYears; year++){
+				Globals->currYear = year;
+				_run_spinup();
+			}
+			cellsDone++;
+		}
+	}
+	unload_cell(); // Reset the global variables
+
+	return (long) cellsDone * SuperGlobals.runInitializationYears;
+}
+
+/* Run all cells that requested initialization through one initialization
+   year before starting the next year. Methods that exchange information
+   between cells, like seed dispersal, need this order, and so does any
+   method without --streams because cells then share their generators.
+   Returns the number of cell-years simulated. */
+static long _initialize_by_year(void){
+	int i, j;
+	long cellYears = 0;
+	IntS year;
+
     /* Iterate through the number of years requested in inputs. */
     for (year = 1; year <= SuperGlobals.runInitializationYears; year++)
     {
@@ -120,20 +210,15 @@ void runInitialization(void){
             for(j = 0; j < grid_Cols; ++j)
             { // for each column
                 // If we should run spinup on this cell
-                if(gridCells[i][j].mySpeciesInit.useInitialization){
+                if(gridCells[i][j].mySpeciesInit.useInitialization && cell_in_range(i, j)){
                     // Load up a cell
-                    load_cell(i, j);
+                    _load_initialization_cell(i, j);
                 } else {
                     continue; // No spinup requested. Move on to next cell.
                 }
 
-                /* This step is important. load_cell loaded in the actual accumulators, but we do not want
-                    to accumulate stats while in spinup. We need to load in dummy accumulators to ensure
-                    we ignore everything that happens in spinup. */
-                stat_Copy_Accumulators(dummy_Dist, dummy_Ppt, dummy_Temp, dummy_Grp, dummy_Gsize, dummy_Gpr, dummy_Gmort, dummy_Gestab,
-                                        dummy_Spp, dummy_Indv, dummy_Smort, dummy_Sestab, dummy_Sreceived, dummy_Gwf, TRUE);
-
                 Globals->currYear = year;
+                cellYears++;
 
                 switch (initializationMethod){
 		            case INIT_WITH_SPINUP:
@@ -151,14 +236,17 @@ void runInitialization(void){
         unload_cell(); // Reset the global variables
     } /* end model run for this year*/
 
-    ChDir(grid_directories[GRID_DIRECTORY_STEPWAT_INPUTS]);
-    SXW_Reset(gridCells[0][0].mySXW->f_watin);
-    //TODO: This is a shortcut. swc history is not used and shouldn't be until this is fixed.
-    Mem_Free(SW_Soilwat.hist.file_prefix);
-    SW_Soilwat.hist.file_prefix = NULL;
-    ChDir("..");
+	return cellYears;
+}
 
-	_endInitialization();
+/* Load a cell for initialization. load_cell loads in the actual accumulators,
+   but we do not want to accumulate stats while in initialization. This
+   replaces them with empty accumulators to ensure we ignore everything that
+   happens in initialization. */
+static void _load_initialization_cell(int row, int col){
+	load_cell(row, col);
+	stat_Copy_Accumulators(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	                       NULL, NULL, NULL, NULL, NULL, NULL, TRUE);
 }
 
 /* Prepares for initialization by turning on species that have requested initialization and turning off 
@@ -213,41 +301,189 @@ static void _endInitialization(void){
  * This is low level function. If you have already called
  * _endInitialization() there is no need to call this function. */
 static void _saveAsInitializationConditions(){
-	// Save gridCells as initializationCells
-	initializationCells = gridCells;
-	// Nullify gridCells. This ensures we can no longer modify initializationCells on accident.
-	gridCells = NULL;
+	int row, col;
+
+	_snapshots = (CellSnapshot*) Mem_Calloc(grid_Rows * grid_Cols, sizeof(CellSnapshot),
+	                                        "_saveAsInitializationConditions");
 
-	// The easiest way to reallocate gridCells is reread the files.
-	rereadInputs();
+	for(row = 0; row < grid_Rows; ++row){
+		for(col = 0; col < grid_Cols; ++col){
+			// Cells outside of --cells are never simulated.
+			if(!cell_in_range(row, col)){
+				continue;
+			}
+			load_cell(row, col);
+			_take_snapshot(&_snapshots[col + (row * grid_Cols)]);
+		}
+	}
+	unload_cell();
 }
 
 /* Load the state of the program right after initialization. */
 void loadInitializationConditions(){
 	int row, col;
-	GrpIndex rg;
-	SppIndex sp;
 
 	for(row = 0; row < grid_Rows; ++row){
 		for(col = 0; col < grid_Cols; ++col){
+			if(!cell_in_range(row, col)){
+				continue;
+			}
 			load_cell(row, col);
+			_restore_snapshot(&_snapshots[col + (row * grid_Cols)]);
+		}
+	}
+	unload_cell();
+}
 
-			ForEachSpecies(sp){
-				copy_species(initializationCells[row][col].mySpecies[sp], Species[sp]);
-			}
+/* Copy the state of the loaded cell into snap. */
+static void _take_snapshot(CellSnapshot *snap){
+	SppIndex sp;
+	GrpIndex rg;
+	IndivType *ndv, *dest;
+	int nIndivs = 0;
+
+	snap->species = (SpeciesType*) Mem_Calloc(Globals->sppCount, sizeof(SpeciesType), "_take_snapshot: species");
+	snap->groups = (GroupType*) Mem_Calloc(Globals->grpCount, sizeof(GroupType), "_take_snapshot: groups");
+	snap->indivCount = (int*) Mem_Calloc(Globals->sppCount, sizeof(int), "_take_snapshot: indivCount");
+
+	ForEachSpecies(sp){
+		snap->species[sp] = *Species[sp];
+		for(ndv = Species[sp]->IndvHead; ndv; ndv = ndv->Next){
+			snap->indivCount[sp]++;
+		}
+		nIndivs += snap->indivCount[sp];
+	}
+	ForEachGroup(rg){
+		snap->groups[rg] = *RGroup[rg];
+	}
+
+	snap->indivs = (IndivType*) Mem_Calloc(nIndivs > 0 ? nIndivs : 1, sizeof(IndivType), "_take_snapshot: indivs");
+	dest = snap->indivs;
+	ForEachSpecies(sp){
+		for(ndv = Species[sp]->IndvHead; ndv; ndv = ndv->Next){
+			*dest++ = *ndv;
+		}
+	}
+
+	snap->arrays = (char*) Mem_Calloc(_copy_cell_arrays(NULL, TRUE) + 1, sizeof(char), "_take_snapshot: arrays");
+	_copy_cell_arrays(snap->arrays, TRUE);
 
-			ForEachGroup(rg){
-				copy_rgroup(initializationCells[row][col].myGroup[rg], RGroup[rg]);
+	snap->environment = *Env;
+	snap->plot = *Plot;
+	snap->succulent = *Succulent;
+}
+
+/* Overwrite the state of the loaded cell with snap. The pointer members of
+   Species and RGroup keep pointing at the cell's own memory; only what they
+   point to is overwritten. The individuals are rebuilt from snap. */
+static void _restore_snapshot(const CellSnapshot *snap){
+	SppIndex sp;
+	GrpIndex rg;
+	const IndivType *src = snap->indivs;
+	IndivType *ndv, *prev;
+	SpeciesType storage;
+	GroupType group;
+	IntUS *kills, *seedprod;
+	SppIndex *est_spp, *species;
+	char *name;
+	int n;
+
+	ForEachSpecies(sp){
+		kills = Species[sp]->kills;
+		seedprod = Species[sp]->seedprod;
+		name = Species[sp]->name;
+		storage = *Species[sp];
+		*Species[sp] = snap->species[sp];
+		Species[sp]->kills = kills;
+		Species[sp]->seedprod = seedprod;
+		Species[sp]->name = name;
+		Species[sp]->indivs = storage.indivs;
+		Species[sp]->indivCapacity = storage.indivCapacity;
+		Species[sp]->indivSpare = storage.indivSpare;
+		Species[sp]->indivSpareCapacity = storage.indivSpareCapacity;
+
+		// Plot_Initialize killed everyone, but make sure no individual is lost.
+		Indiv_Clear(Species[sp]);
+		Indiv_Reserve(Species[sp], snap->indivCount[sp]);
+
+		prev = NULL;
+		for(n = 0; n < snap->indivCount[sp]; ++n){
+			ndv = Indiv_Alloc(Species[sp]);
+			*ndv = *src++;
+			ndv->Prev = prev;
+			ndv->Next = NULL;
+			if(prev){
+				prev->Next = ndv;
+			} else {
+				Species[sp]->IndvHead = ndv;
 			}
+			prev = ndv;
+		}
+	}
 
-			copy_environment(&initializationCells[row][col].myEnvironment, Env);
-			copy_plot(&initializationCells[row][col].myPlot, Plot);
-			copy_succulent(&initializationCells[row][col].mySucculent, Succulent);
+	ForEachGroup(rg){
+		kills = RGroup[rg]->kills;
+		est_spp = RGroup[rg]->est_spp;
+		species = RGroup[rg]->species;
+		name = RGroup[rg]->name;
+		group = *RGroup[rg];
+		*RGroup[rg] = snap->groups[rg];
+		RGroup[rg]->kills = kills;
+		RGroup[rg]->est_spp = est_spp;
+		RGroup[rg]->species = species;
+		RGroup[rg]->name = name;
+		RGroup[rg]->sorted = group.sorted;
+		RGroup[rg]->sortScratch = group.sortScratch;
+		RGroup[rg]->sortedCapacity = group.sortedCapacity;
+		RGroup_InvalidateSorted(RGroup[rg]);
+	}
+
+	_copy_cell_arrays(snap->arrays, FALSE);
+
+	*Env = snap->environment;
+	*Plot = snap->plot;
+	*Succulent = snap->succulent;
+}
+
+/* Copy every array that Species and RGroup of the loaded cell point to into
+   arrays (take is TRUE) or back out of it (take is FALSE). The arrays are
+   packed one after the other. Pass NULL for arrays to only count the bytes
+   needed. Returns the number of bytes copied. */
+static size_t _copy_cell_arrays(char *arrays, Bool take){
+	SppIndex sp;
+	GrpIndex rg;
+	size_t used = 0;
 
-			unload_cell();
+	ForEachSpecies(sp){
+		if(Species[sp]->kills){
+			used += _copy_array(arrays, used, Species[sp]->kills, SppMaxAge(sp) * sizeof(IntUS), take);
 		}
+		if(Species[sp]->seedprod){
+			used += _copy_array(arrays, used, Species[sp]->seedprod, Species[sp]->viable_yrs * sizeof(IntUS), take);
+		}
+	}
+	ForEachGroup(rg){
+		if(RGroup[rg]->kills){
+			used += _copy_array(arrays, used, RGroup[rg]->kills, GrpMaxAge(rg) * sizeof(IntUS), take);
+		}
+		used += _copy_array(arrays, used, RGroup[rg]->est_spp, SuperGlobals.max_spp_per_grp * sizeof(SppIndex), take);
+		used += _copy_array(arrays, used, RGroup[rg]->species, SuperGlobals.max_spp_per_grp * sizeof(SppIndex), take);
 	}
 
+	return used;
+}
+
+/* Copy size bytes between live and arrays + offset. Does nothing if arrays
+   is NULL. Returns size. */
+static size_t _copy_array(char *arrays, size_t offset, void *live, size_t size, Bool take){
+	if(arrays){
+		if(take){
+			memcpy(arrays + offset, live, size);
+		} else {
+			memcpy(live, arrays + offset, size);
+		}
+	}
+	return size;
 }
 
 /* "Spinup" the model by running without stat collection, fire, or grazing.
@@ -266,6 +502,7 @@ static void _run_spinup(void)
     killAnnuals(); 			// Kill annuals
     killMaxage();             // Kill plants that reach max age
     killExtraGrowth(); 		// Kill superfluous growth			
+    scratch_Reset();			// Release this year's scratch arrays
 }
 
 /* TODO: This is a dummy method. It needs to be implemented once seed dispersal is fully planned.
@@ -290,19 +527,26 @@ static void _run_seed_initialization(void){
 	return;
 }
 
-/* Free memory allocated to initializationCells. This function should only be called once per simulation. */
+/* Free the snapshots taken at the end of initialization. This function should only be called once per simulation. */
 void freeInitializationMemory(void)
 {
-	// Remember where gridCells pointed.
-	CellType** locationOfGridCells = gridCells;
-
-	// If initializationCells is allocated.
-	if(initializationCells){
-		// move gridCells to point to initializationCells. This allows us to deallocate using free_grid_memory();
-		gridCells = initializationCells;
-		// Since we already have a function to deallocate gridCells we can use it.
-		free_grid_memory();
-		// And we need to reset gridCells in case it hasn't been deallocated.
-		gridCells = locationOfGridCells;
+	int cell;
+
+	if(!_snapshots){
+		return;
+	}
+
+	for(cell = 0; cell < grid_Rows * grid_Cols; ++cell){
+		// Cells outside of --cells have no snapshot.
+		if(!_snapshots[cell].species){
+			continue;
+		}
+		Mem_Free(_snapshots[cell].species);
+		Mem_Free(_snapshots[cell].groups);
+		Mem_Free(_snapshots[cell].indivCount);
+		Mem_Free(_snapshots[cell].indivs);
+		Mem_Free(_snapshots[cell].arrays);
 	}
-}
\ No newline at end of file
+	Mem_Free(_snapshots);
+	_snapshots = NULL;
+}
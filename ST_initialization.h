@@ -31,8 +31,6 @@ void freeInitializationMemory(void);
 
 /************************ Exported variables ****************************/
 
-/* Stores the state of the cells following spinup. */
-CellType** initializationCells;
 /* The method of initialization specified in inputs. */
 InitializationMethod initializationMethod;
 /* TRUE if the program is currently in initialization. */
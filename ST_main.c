@@ -38,6 +38,10 @@
 #include "ST_progressBar.h"
 #include "ST_seedDispersal.h"
 #include "ST_mortality.h"
+#include "ST_grid.h"
+#include "ST_workers.h"
+#include "ST_checkpoint.h"
+#include "ST_scratch.h"
 
 extern Bool prepare_IterationSummary; // defined in `SOILWAT2/SW_Output.c`
 extern Bool print_IterationSummary; // defined in `SOILWAT2/SW_Output_outtext.c`
@@ -53,9 +57,11 @@ SW_FILE_STATUS SW_File_Status;
   void rgroup_Establish( void) ;
   void rgroup_IncrAges( void);
   void rgroup_PartResources( void);
+  void rgroup_FreePartitionMemory( void);
 
   void parm_Initialize(void);
   void parm_SetFirstName( char *s);
+  unsigned int parm_InputChecksum(void);
 
   void output_Bmass_Yearly( Int year );
   void output_Mort_Yearly( void );
@@ -88,7 +94,8 @@ void Plot_Initialize( void);
  */
 static void usage(void) {
   char *s ="STEPPE plant community dynamics (SGS-LTER Jan-04).\n"
-           "   Usage : steppe [-d startdir] [-f files.in] [-q] [-e] [-o] [-g]\n"
+           "   Usage : steppe [-d startdir] [-f files.in] [-q] [-e] [-o] [-g] [-j workers] [--cells=begin:end] [--merge]\n"
+           "                 [--checkpoint=N] [--resume] [--streams]\n"
            "      -d : supply working directory (default=.)\n"
            "      -f : supply list of input files (default=files.in)\n"
            "      -q : quiet mode, don't print message to check logfile.\n"
@@ -97,6 +104,14 @@ static void usage(void) {
            "      -o : write SOILWAT output to output files. Contains average over all iterations and standard deviation.\n"
            "      -g : use gridded mode\n"
            "      -i : write SOILWAT output to output files for each iteration\n" // dont need to set -o flag to use this flag
+           "      -j : run iterations in this many processes at once (non-gridded mode only)\n"
+           " --cells=begin:end : gridded mode only. Simulate cells begin to end-1 and write their\n"
+           "                     statistics to a shard file instead of the cell average files.\n"
+           " --merge : gridded mode only. Combine the shard files into the cell average files.\n"
+           " --checkpoint=N : write a checkpoint after every N iterations.\n"
+           " --resume : continue an interrupted run from its last checkpoint.\n"
+           " --streams : give every cell, iteration and process its own random number streams.\n"
+           "             Needed by -j, --cells, --checkpoint and --resume. Changes the results.\n"
 		   "-STdebug : generate sqlite database with STEPWAT information\n";
   fprintf(stderr,"%s", s);
   exit(0);
@@ -104,6 +119,16 @@ static void usage(void) {
 
 static void init_args(int argc, char **argv);
 static void check_log(void);
+static void _run_iteration(IntS iter);
+
+static IntS _read_checkpoint(void);
+static void _write_checkpoint(IntS iterationsDone);
+
+/* Number of processes that run iterations at the same time. Set with -j. */
+static int nWorkers = 1;
+
+/* Where non-gridded mode writes its checkpoint. */
+#define CHECKPOINT_FILE "Output/checkpoint.bin"
 
 void allocate_Globals(void);
 void deallocate_Globals(Bool isGriddedMode);
@@ -171,8 +196,7 @@ extern pcg32_random_t markov_rng;
  * user requests gridded mode this function calls RunGrid.
  */
 int main(int argc, char **argv) {
-  IntS year, iter;
-	Bool killedany;
+  IntS iter, firstIter = 1;
 
 	logged = FALSE;
 	atexit(check_log);
@@ -199,6 +223,11 @@ int main(int argc, char **argv) {
 	allocate_Globals();
 
 	parm_Initialize();
+	if ((checkpointInterval > 0 || resumeFromCheckpoint) && SuperGlobals.randseed == 0) {
+		LogError(logfp, LOGFATAL, "--checkpoint and --resume need a seed in the model input "
+		         "file, so the resumed run draws the same random numbers.");
+	}
+	SimContext_SetSeed();
         
 	SXW_Init(TRUE, NULL); // allocate SOILWAT2-memory
 	SW_OUT_set_ncol(); // set number of output columns
@@ -214,108 +243,62 @@ int main(int argc, char **argv) {
 	    ST_connect("Output/stdebug");
 	}
 
-	/* --- Begin a new iteration ------ */
-	for (iter = 1; iter <= SuperGlobals.runModelIterations; iter++) {
-		Plot_Initialize();
+	/* --- Run the iterations ------ */
+	if (nWorkers > 1 && (prepare_IterationSummary || storeAllIterations
+	                     || STdebug_requested || !isnull(SXW->debugfile))) {
+		LogError(logfp, LOGWARN, "-j is ignored together with -o, -i, -s or -STdebug "
+		         "because their output is written by a single process.");
+		nWorkers = 1;
+	}
 
-		RandSeed(SuperGlobals.randseed, &environs_rng);
-		RandSeed(SuperGlobals.randseed, &mortality_rng);
-		RandSeed(SuperGlobals.randseed, &resgroups_rng);
-		RandSeed(SuperGlobals.randseed, &species_rng);
-		RandSeed(SuperGlobals.randseed, &grid_rng);
-		RandSeed(SuperGlobals.randseed, &markov_rng);
+	if (nWorkers > 1 && !useRNGStreams) {
+		LogError(logfp, LOGWARN, "-j is ignored without --streams because the iterations "
+		         "then depend on each other.");
+		nWorkers = 1;
+	}
 
-		Globals->currIter = iter;
-                
-		if (storeAllIterations) {
-			SW_OUT_create_iteration_files(Globals->currIter);
+	if (checkpointInterval > 0 || resumeFromCheckpoint) {
+		if (!useRNGStreams) {
+			LogError(logfp, LOGFATAL, "--checkpoint and --resume require --streams, because without it "
+			         "the random number generators carry state from one iteration into the next.");
 		}
-
-		if (prepare_IterationSummary) {
-			print_IterationSummary = (Bool) (Globals->currIter == SuperGlobals.runModelIterations);
+		if (prepare_IterationSummary || STdebug_requested) {
+			LogError(logfp, LOGFATAL, "--checkpoint and --resume can not be combined with -o or -STdebug "
+			         "because their output spans all iterations.");
 		}
+		if (nWorkers > 1) {
+			LogError(logfp, LOGWARN, "-j is ignored together with --checkpoint or --resume.");
+			nWorkers = 1;
+		}
+		if (resumeFromCheckpoint) {
+			firstIter = _read_checkpoint() + 1;
+		}
+	}
 
-		/* ------  Begin running the model ------ */
-		for (year = 1; year <= SuperGlobals.runModelYears; year++) {
-            if(UseProgressBar){
-                logProgress(iter, year, SIMULATION);
-            }
-
-			//printf("------------------------Repetition/year = %d / %d\n", iter, year);
-
-			Globals->currYear = year;
-
-			rgroup_Establish();
-
-			Env_Generate();
-
-			rgroup_PartResources();
-
-			if (!isnull(SXW->debugfile) ) SXW_PrintDebug(0);
-
-			rgroup_Grow();
-
-			mort_Main(&killedany);
-
-			rgroup_IncrAges();
-
-			// Added functions for Grazing and mort_end_year as proportional killing effect before exporting biomass end of the year
-			grazing_EndOfYear();
-
-			save_annual_species_relsize();
-
-      		mort_EndOfYear();
-
-			stat_Collect(year);
+	if (nWorkers > 1) {
+		workers_RunIterations(nWorkers, _run_iteration);
+	} else {
+		for (iter = firstIter; iter <= SuperGlobals.runModelIterations; iter++) {
+			_run_iteration(iter);
 
-			if (BmassFlags.yearly)
-				output_Bmass_Yearly(year);
+			// dont need to restart if last iteration finished
+			// this keeps it from re-writing the output folder and overwriting output files
+			if (iter != SuperGlobals.runModelIterations)
+			{
+				// don't reset in last iteration because we need to close files
+				// before clearing/de-allocated SOILWAT2-memory
+				SXW_Reset(SXW->f_watin);
 
-			// Moved kill annual and kill extra growth after we export biomass, and recovery of biomass after fire before the next year
-			killAnnuals();
-                        
-			killMaxage();
-
-			proportion_Recovery();
-
-			killExtraGrowth();
-			
-			// if the user requests the stdebug.sqlite3 file to be generated
-			// it is populated here.
-			if(STdebug_requested){
-				//species info
-				ForEachSpecies(sp) {
-					//individual info
-					insertSpecieYearInfo(sp);
-					for ((ndv) = Species[sp]->IndvHead; (ndv) != NULL; (ndv) = (ndv)->Next) {
-						insertIndivYearInfo(ndv);
-						insertIndiv(ndv);
-					}
-				}
-				//Rgroup info
-				ForEachGroup(rg){
-					insertRGroupYearInfo(rg);
+				if (checkpointInterval > 0 && iter % checkpointInterval == 0) {
+					_write_checkpoint(iter);
 				}
 			}
-		} /* end model run for this year*/
-
-		if (MortFlags.summary) {
-			stat_Collect_GMort();
-			stat_Collect_SMort();
 		}
-
-		if (MortFlags.yearly)
-			output_Mort_Yearly(); // writes yearly file
-
-		// dont need to restart if last iteration finished
-		// this keeps it from re-writing the output folder and overwriting output files
-		if (Globals->currIter != SuperGlobals.runModelIterations)
-		{
-			// don't reset in last iteration because we need to close files
-			// before clearing/de-allocated SOILWAT2-memory
-			SXW_Reset(SXW->f_watin);
+		// The run finished, so there is nothing left to resume.
+		if (checkpointInterval > 0 || resumeFromCheckpoint) {
+			remove(CHECKPOINT_FILE);
 		}
-	} /* end model run for this iteration*/
+	}
 
     if(UseProgressBar){
         logProgress(0, 0, OUTPUT);
@@ -351,6 +334,151 @@ int main(int argc, char **argv) {
 	return 0;
 }
 /* END PROGRAM */
+
+/** \brief Runs one iteration of the non-gridded model.
+ * 
+ * Expects SOILWAT2 to be freshly initialized or reset with SXW_Reset.
+ * Statistics of the iteration are added to the accumulators.
+ * 
+ * \param iter is the iteration to run, base 1.
+ * 
+ * \sa workers_RunIterations(), which calls this function from several
+ *     processes when the -j flag is used.
+ */
+static void _run_iteration(IntS iter) {
+	IntS year;
+	Bool killedany;
+
+	Plot_Initialize();
+
+	/* With --streams every iteration draws from its own streams so it does
+	   not depend on the iterations before it, which is what lets -j run them
+	   anywhere. */
+	SimContext_SeedProcessRNGs(iter);
+
+	Globals->currIter = iter;
+                
+	if (storeAllIterations) {
+		SW_OUT_create_iteration_files(Globals->currIter);
+	}
+
+	if (prepare_IterationSummary) {
+		print_IterationSummary = (Bool) (Globals->currIter == SuperGlobals.runModelIterations);
+	}
+
+	/* ------  Begin running the model ------ */
+	for (year = 1; year <= SuperGlobals.runModelYears; year++) {
+            if(UseProgressBar){
+                logProgress(iter, year, SIMULATION);
+            }
+
+		//printf("------------------------Repetition/year = %d / %d\n", iter, year);
+
+		Globals->currYear = year;
+
+		rgroup_Establish();
+
+		Env_Generate();
+
+		rgroup_PartResources();
+
+		if (!isnull(SXW->debugfile) ) SXW_PrintDebug(0);
+
+		rgroup_Grow();
+
+		mort_Main(&killedany);
+
+		rgroup_IncrAges();
+
+		// Added functions for Grazing and mort_end_year as proportional killing effect before exporting biomass end of the year
+		grazing_EndOfYear();
+
+		save_annual_species_relsize();
+
+      		mort_EndOfYear();
+
+		stat_Collect(year);
+
+		if (BmassFlags.yearly)
+			output_Bmass_Yearly(year);
+
+		// Moved kill annual and kill extra growth after we export biomass, and recovery of biomass after fire before the next year
+		killAnnuals();
+                        
+		killMaxage();
+
+		proportion_Recovery();
+
+		killExtraGrowth();
+		
+		// if the user requests the stdebug.sqlite3 file to be generated
+		// it is populated here.
+		if(STdebug_requested){
+			//species info
+			ForEachSpecies(sp) {
+				//individual info
+				insertSpecieYearInfo(sp);
+				for ((ndv) = Species[sp]->IndvHead; (ndv) != NULL; (ndv) = (ndv)->Next) {
+					insertIndivYearInfo(ndv);
+					insertIndiv(ndv);
+				}
+			}
+			//Rgroup info
+			ForEachGroup(rg){
+				insertRGroupYearInfo(rg);
+			}
+		}
+
+		// Release this year's scratch arrays.
+		scratch_Reset();
+	} /* end model run for this year*/
+
+	if (MortFlags.summary) {
+		stat_Collect_GMort();
+		stat_Collect_SMort();
+	}
+
+	if (MortFlags.yearly)
+		output_Mort_Yearly(); // writes yearly file
+}
+
+/** \brief Writes a checkpoint of the plot after iterationsDone iterations.
+ * 
+ * Call this between iterations, after SOILWAT2 has been reset.
+ * 
+ * \sa ST_checkpoint.c
+ */
+static void _write_checkpoint(IntS iterationsDone) {
+	CheckpointHeader header;
+	FILE *f;
+
+	checkpoint_InitHeader(&header, 1, 1, 0, 1, parm_InputChecksum());
+	header.iterationsDone = iterationsDone;
+	f = checkpoint_Create(CHECKPOINT_FILE, &header);
+	if (!checkpoint_WritePlot(f)) {
+		LogError(logfp, LOGFATAL, "Could not write checkpoint %s", CHECKPOINT_FILE);
+	}
+	checkpoint_Commit(f, CHECKPOINT_FILE);
+}
+
+/** \brief Restores the plot from the checkpoint of an interrupted run.
+ * 
+ * \return the number of iterations the checkpoint covers.
+ */
+static IntS _read_checkpoint(void) {
+	CheckpointHeader header;
+	FILE *f;
+
+	checkpoint_InitHeader(&header, 1, 1, 0, 1, parm_InputChecksum());
+	f = checkpoint_Open(CHECKPOINT_FILE, &header);
+	if (!checkpoint_ReadPlot(f)) {
+		LogError(logfp, LOGFATAL, "Checkpoint %s ended early.", CHECKPOINT_FILE);
+	}
+	CloseFile(&f);
+
+	printf("Resuming after iteration %d\n", header.iterationsDone);
+	return header.iterationsDone;
+}
 #endif
 
 /** \brief (re)initializes the plot.
@@ -465,14 +593,8 @@ void deallocate_Globals(Bool isGriddedMode){
 		Mem_Free(Species[sp]->kills);
 		Mem_Free(Species[sp]->seedprod);
 		Mem_Free(Species[sp]->name);
-		IndivType *indv = Species[sp]->IndvHead, *next;
-		/* Next free the linked list of individuals */
-		while(indv){
-			next = indv->Next;
-			Mem_Free(indv);
-			indv = next;
-		}
-		Mem_Free(indv);
+		/* Next free the individuals */
+		Indiv_FreeStorage(Species[sp]);
 		/* Finally free the actual species */
 		Mem_Free(Species[sp]);
 	}
@@ -486,15 +608,19 @@ void deallocate_Globals(Bool isGriddedMode){
 		Mem_Free(RGroup[rg]->kills);
 		Mem_Free(RGroup[rg]->name);
 		Mem_Free(RGroup[rg]->species);
+		Mem_Free(RGroup[rg]->sorted);
+		Mem_Free(RGroup[rg]->sortScratch);
 		Mem_Free(RGroup[rg]);
 	}
 	/* Then free the entire array */
 	Mem_Free(RGroup);
+	rgroup_FreePartitionMemory();
+	scratch_Free();
 }
 
 /** \brief Translates the input flags to in program flags.
  * 
- * The recognised flags are -d, -f, -q, -e, -p, -g, -o, -i, -s and -S.
+ * The recognised flags are -d, -f, -q, -e, -p, -g, -o, -i, -j, -s and -S.
  * Note that flags are case sensitive. 
  * 
  * When the -f flag is uses this function looks next for the name of the file.
@@ -523,10 +649,18 @@ static void init_args(int argc, char **argv) {
    * 8/16/17 - BEB  Updated option for -o flag. Now if this flag is set the output files from
    *                files_v30.in are written to.
    * 10/9/17 - BEB Added -i flag for writing SOILWAT output for every iteration
+   * -j N runs the iterations of a non-gridded simulation in N processes.
+   * --cells=begin:end and --merge split a gridded run across processes.
+   *         Both share the "--" entry of opts[] and are told apart in the
+   *         switch statement.
+   * --checkpoint=N writes a checkpoint every N iterations and --resume
+   *         continues from it. They share the "--" entry as well.
+   * --streams gives every cell, iteration and subsystem its own random
+   *         number stream. Also part of the "--" entry.
    */
   char str[1024],
-       *opts[]  = {"-d","-f","-q","-e", "-p", "-g", "-o", "-i", "-s", "-S"};  /* valid options */
-  int valopts[] = {  1,   1,   0,  -1,   0,    0,    0,   0,   0,   0};  /* indicates options with values */
+       *opts[]  = {"-d","-f","-q","-e", "-p", "-g", "-o", "-i", "-s", "-S", "--", "-j"};  /* valid options */
+  int valopts[] = {  1,   1,   0,  -1,   0,    0,    0,   0,   0,   0,    1,    1};  /* indicates options with values */
                  /* 0=none, 1=required, -1=optional */
   int i, /* looper through all cmdline arguments */
       a, /* current valid argument-value position */
@@ -659,6 +793,31 @@ static void init_args(int argc, char **argv) {
 				usage();
 			}
 
+		case 10: // --cells=begin:end, --merge, --checkpoint=N, --resume or --streams
+			if (2 == sscanf(str, "cells=%d:%d", &cellRangeBegin, &cellRangeEnd)) {
+				useCellRange = TRUE;
+			} else if (!strcmp(str, "merge")) {
+				mergeCellShards = TRUE;
+			} else if (1 == sscanf(str, "checkpoint=%d", &checkpointInterval) && checkpointInterval > 0) {
+				printf("writing a checkpoint every %d iterations\n", checkpointInterval);
+			} else if (!strcmp(str, "resume")) {
+				resumeFromCheckpoint = TRUE;
+			} else if (!strcmp(str, "streams")) {
+				useRNGStreams = TRUE;
+			} else {
+				fprintf(stderr, "Invalid option %s\n", argv[a]);
+				usage();
+			}
+			break;
+
+		case 11: // -j
+			nWorkers = atoi(str);
+			if (nWorkers < 1) {
+				fprintf(stderr, "-j needs a positive number of workers\n");
+				usage();
+			}
+			break;
+
 		default:
 			LogError(logfp, LOGFATAL,
 					"Programmer: bad option in main:init_args:switch");
@@ -693,7 +852,9 @@ static void check_log(void) {
 
 /** \brief Compares the getRelsize funcitons to calculated values.
  * 
- * Used for debugging. 
+ * Used for debugging. getSpeciesRelsize() returns a total that is kept up
+ * to date as individuals change; this recomputes it from the individuals.
+ * Compile with -DDEBUG_RELSIZE to run this check every year.
  * 
  * \sa getSpeciesRelsize
  * \sa getRGroupRelsize
@@ -718,7 +879,7 @@ void check_sizes(const char *chkpt) {
 
         ForEachEstSpp(sp, rg, i) {
 
-            spsize = 0.0;
+            spsize = Species[sp]->extragrowth;
             ForEachIndiv(ndv, Species[sp]) spsize += ndv->relsize;
             rgsize += spsize;
 
@@ -33,6 +33,7 @@
 #include "ST_globals.h"
 #include "sw_src/pcg/pcg_basic.h"
 #include "sxw_vars.h"
+#include "ST_scratch.h"
 
 /******** Modular External Function Declarations ***********/
 /* -- truly global functions are declared in functions.h --*/
@@ -64,6 +65,12 @@ Bool _simulateWildfire(double cheatgrassCover);
 Bool _simulatePrescribedFire(void);
 double _getCheatgrassBiomass(void);
 
+/* ------------------------ Exported mortality objects ----------------------- */
+/* Declared in ST_mortality.h. Defined here so C++ tests can include the header
+   from more than one file. */
+pcg32_random_t mortality_rng;
+Bool UseCheatgrassWildfire;
+
 /********************** Private mortality objects ****************************/
 /**
  * \brief [Mortality](\ref MORTALITY)'s private precipitation information.
@@ -214,6 +221,10 @@ void mort_Main( Bool *killed) {
   } /* end ForEachGroup(rg) */
 
   killed = _SomeKillage;
+
+#ifdef DEBUG_RELSIZE
+  check_sizes("mort_Main");
+#endif
 }
 
 /**
@@ -662,7 +673,7 @@ static void _pat( const SppIndex sp) {
     Int i, k=-1;
     IndivType *p, **kills;
     
-    kills = (IndivType **)Mem_Calloc(SuperGlobals.max_indivs_per_spp, sizeof(IndivType *), "_pat");
+    kills = (IndivType **)scratch_Alloc(SuperGlobals.max_indivs_per_spp, sizeof(IndivType *), "_pat");
 
     /* ---------------------------------------------*/
     /* Generate kill list, depending on sensitivity */
@@ -692,8 +703,6 @@ static void _pat( const SppIndex sp) {
     }
 
     if (k >= 0) *_SomeKillage = TRUE;
-    
-    Mem_Free(kills);
 }
 
 
@@ -795,7 +804,7 @@ static void _succulents( const SppIndex sp) {
   RealF killamt = Succulent->reduction;
   int i, k=0;
   
-  kills = (IndivType **)Mem_Calloc(SuperGlobals.max_indivs_per_spp, sizeof(IndivType *), "_succulents");
+  kills = (IndivType **)scratch_Alloc(SuperGlobals.max_indivs_per_spp, sizeof(IndivType *), "_succulents");
 
   ForEachIndiv (p, Species[sp]) {
     if ( GT(p->relsize, killamt) )
@@ -809,8 +818,6 @@ static void _succulents( const SppIndex sp) {
 
 
   if (Species[sp]->est_count) *_SomeKillage = TRUE;
-  
-  Mem_Free(kills);
 }
 
 
@@ -852,7 +859,7 @@ static void _slow_growth( const SppIndex sp) {
   IndivType *ndv,
             **kills;
   
-  kills = (IndivType **)Mem_Calloc(SuperGlobals.max_indivs_per_spp, sizeof(IndivType *), "_slow_growth");
+  kills = (IndivType **)scratch_Alloc(SuperGlobals.max_indivs_per_spp, sizeof(IndivType *), "_slow_growth");
 
   slowrate = RGroup[Species[sp]->res_grp]->slowrate
            * Species[sp]->max_rate;
@@ -874,8 +881,6 @@ static void _slow_growth( const SppIndex sp) {
     indiv_Kill_Complete(kills[n], 8);
 
   if (k >= 0) *_SomeKillage = TRUE;
-  
-  Mem_Free(kills);
 }
 
 /**
@@ -914,7 +919,7 @@ static void _age_independent( const SppIndex sp) {
 
   if (SppMaxAge(sp) == 1) return;
 
-  kills = (IndivType **) Mem_Calloc(Species[sp]->est_count,
+  kills = (IndivType **) scratch_Alloc(Species[sp]->est_count,
                                    sizeof(IndivType *),
                                    "_age_independent(kills)");
 
@@ -932,9 +937,6 @@ static void _age_independent( const SppIndex sp) {
   }
 
   if (k >= 0) *_SomeKillage = TRUE;
-
-  Mem_Free(kills);
-
 }
 
 /**
@@ -974,13 +976,16 @@ static void _no_resources( GrpIndex rg) {
        n,   /* number of individuals in group */
        nk;  /* number of plants to kill */
 
-  /* to-be-sorted list of indivs*/
+  /* sorted list of indivs, owned by the group */
   IndivType **indv_list;
 
 
   /*----------------------------------------------------*/
-  /* get a sorted list of individuals in this rgroup*/
-  indv_list = RGroup_GetIndivs(rg, SORT_A, &n);
+  /* get a sorted list of individuals in this rgroup.
+   * Every kill below changes indivChanges, so calling RGroup_SortedIndivs()
+   * again before _stretched_clonal() returns would rebuild the list that
+   * indv_list points to. Keep using this one. */
+  indv_list = RGroup_SortedIndivs(rg, SORT_A, &n);
 
   /*----------------------------------------------------*/
   /* kill until nk reached   (EQN 7)    */
@@ -1000,8 +1005,6 @@ static void _no_resources( GrpIndex rg) {
    * exits before doing anything. */
   _stretched_clonal( rg, i, n-1, indv_list);
 
-  Mem_Free( indv_list);
-
 }
 
 /**
@@ -1039,7 +1042,9 @@ static void _stretched_clonal( GrpIndex rg, Int start, Int last,
 
   IndivType **clist; /* list of clonal individuals */
 
-  clist = (IndivType **)Mem_Calloc(SuperGlobals.max_indivs_per_spp, sizeof(IndivType *), "_stretched_clonal");
+  /* Room for every individual from start to last; a group can hold more
+     individuals than max_indivs_per_spp */
+  clist = (IndivType **)scratch_Alloc(max(last - start + 1, 0), sizeof(IndivType *), "_stretched_clonal");
   
   /* get a list of remaining clonal plants, still ranked by size */
   for( np=-1, i=start; i <= last; i++) {
@@ -1047,10 +1052,7 @@ static void _stretched_clonal( GrpIndex rg, Int start, Int last,
       clist[++np] = nlist[i];
   }
   if (np < 0)
-  {
-    Mem_Free(clist);
     return;  /* Exit if no clonals remain alive in this rgroup */
-  }
 
   y = RGroup[rg]->yrs_neg_pr;
 
@@ -1104,8 +1106,6 @@ static void _stretched_clonal( GrpIndex rg, Int start, Int last,
 
     } /* end if pm*/
   } /* end if y >= 1*/
-
-  Mem_Free(clist);
 }
 
 /**
@@ -1159,6 +1159,8 @@ void killExtraGrowth(void) {
     IntU j;
     GrpIndex rg;
     SppIndex sp;
+    IndivType *p1, *t1;
+    double sumsize;
 
     ForEachGroup(rg) {
 
@@ -1172,12 +1174,16 @@ void killExtraGrowth(void) {
             Species[sp]->extragrowth = 0.0;
 
             /* Now FINALLY remove individuals that were killed because of fire or grazing and set 
-             * relsizes to 0, and remove the Species if the following cases are true */
-            if (getSpeciesRelsize(sp) <= 0.0) {
+             * relsizes to 0, and remove the Species if the following cases are true.
+             * Sum the individuals instead of calling getSpeciesRelsize(): its running total
+             * can be a rounding error away from the exact 0 this test needs. */
+            sumsize = 0.0;
+            ForEachIndiv(p1, Species[sp]) sumsize += p1->relsize;
+            if (sumsize <= 0.0) {
                 // printf("s->relsize in killExtraGrowth check1 before = %f\n", Species[sp]->relsize);
                 // printf("s->relsize in killExtraGrowth check1 after = %f\n", Species[sp]->relsize);
 
-                IndivType *p1 = Species[sp]->IndvHead, *t1;
+                p1 = Species[sp]->IndvHead;
                 while (p1) {
                     t1 = p1->Next;
                     _delete(p1);
@@ -1187,6 +1193,10 @@ void killExtraGrowth(void) {
             }
         }
     }
+
+#ifdef DEBUG_RELSIZE
+    check_sizes("killExtraGrowth");
+#endif
 }
 
 /**
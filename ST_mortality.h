@@ -105,7 +105,7 @@ CheatgrassPrecip* getCheatgrassPrecip(void);
  * 
  * \ingroup MORTALITY
  */
-pcg32_random_t mortality_rng;
+extern pcg32_random_t mortality_rng;
 
 /* ---------------------------- Exported Flags ----------------------------- */
 
@@ -113,7 +113,7 @@ pcg32_random_t mortality_rng;
  * \brief A flag for turning cheatgrass-driven wildfire on and off.
  * \ingroup MORTALITY
  */
-Bool UseCheatgrassWildfire;
+extern Bool UseCheatgrassWildfire;
 
 /* ---------------------------- Exported Enums ----------------------------- */
 
@@ -18,6 +18,7 @@
 #include "ST_globals.h"
 #include "sw_src/filefuncs.h"
 #include "sw_src/myMemory.h"
+#include "ST_scratch.h"
 
 
 /******** Modular External Function Declarations ***********/
@@ -52,11 +53,11 @@ void output_Bmass_Yearly( Int year ) {
   
   if (!BmassFlags.yearly) return;
 
-  fields = (char **)Mem_Calloc(MAX_OUTFIELDS, sizeof(char *), "output_Bmass_Yearly");
-  s = (char *)Mem_Calloc(MAX_FIELDLEN + 1, sizeof(char), "output_Bmass_Yearly");
+  fields = (char **)scratch_Alloc(MAX_OUTFIELDS, sizeof(char *), "output_Bmass_Yearly");
+  s = (char *)scratch_Alloc(MAX_FIELDLEN + 1, sizeof(char), "output_Bmass_Yearly");
   
   for (i = 0; i < MAX_OUTFIELDS; i++) {
-      fields[i] = (char *)Mem_Calloc(MAX_FIELDLEN + 1, sizeof(char), "output_Bmass_Yearly");
+      fields[i] = (char *)scratch_Alloc(MAX_FIELDLEN + 1, sizeof(char), "output_Bmass_Yearly");
   }
   
   if(Globals->currYear == 1) // At year one we need a header.
@@ -188,13 +189,6 @@ void output_Bmass_Yearly( Int year ) {
   if (i) fprintf(Globals->bmass.fp_year,"%s\n", fields[i]);
   fflush(Globals->bmass.fp_year);
   CloseFile(&Globals->bmass.fp_year);
-  
-  for (i = 0; i < MAX_OUTFIELDS; i++) {
-      Mem_Free(fields[i]);
-  }
-  
-  Mem_Free(s);
-  Mem_Free(fields);
 }
 
 
@@ -28,6 +28,7 @@
 #include "sw_src/myMemory.h"
 #include "sw_src/rands.h"
 #include "sxw_funcs.h"
+#include "ST_checkpoint.h"
 
 
 /************ External Variable Declarations ***************/
@@ -48,6 +49,7 @@ SppIndex species_New(void);
   void parm_SetFirstName( char *s);
   void parm_SetName( char *s, int which);
   void parm_free_memory( void );
+  unsigned int parm_InputChecksum(void);
   void maxrgroupspecies_init(void);
   void files_init(void);
 
@@ -1231,6 +1233,21 @@ static void _species_init( void) {
 
 }*/
 
+/**************************************************************/
+unsigned int parm_InputChecksum(void) {
+/*======================================================*/
+/* Checksum of files.in and the STEPPE input files it names, see
+ * checkpoint_ChecksumFile(). Call it from the directory the files
+ * were read from. */
+	const ST_FileIndex inputs[] = {F_First, F_Model, F_Env, F_Plot, F_RGroup, F_Species,
+	                               F_BMassFlag, F_MortFlag, F_SXW, F_MaxRGroupSpecies};
+	unsigned int i, sum = CHECKPOINT_CHECKSUM_START;
+
+	for(i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+		sum = checkpoint_ChecksumFile(sum, _files[inputs[i]]);
+	return sum;
+}
+
 /**************************************************************/
 void parm_free_memory( void ) {
 	//function to free memory allocated in this module
@@ -7,10 +7,16 @@
  */
 /**************************************************************************/
 
+/* clock_gettime() is not part of C99. */
+#define _POSIX_C_SOURCE 200809L
+
 #include "ST_progressBar.h"
 #include "ST_defines.h"
 #include "ST_globals.h"
 #include<string.h>
+#include<time.h>
+
+extern Bool UseProgressBar;             // From ST_main.c
 
 /*************** Local Function(s). Treat these as private. ***************/
 
@@ -87,6 +93,44 @@ void logProgress(int iteration, int year, Status status){
 	}
 }
 
+/* Seconds on a monotonic clock, for timing the phases passed to
+   logThroughput(). Only differences between two calls are meaningful. */
+double throughputClock(void){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/* Report how many cell-years a phase of the program simulated per second.
+   The rate is written to the logfile on every run, without flagging the
+   logfile as holding messages. With -p it is also printed below the
+   progress bar; stdout otherwise stays as quiet as it was.
+	Param phase: name of the phase, e.g. "Initialization".
+	Param cellYears: number of years simulated summed over all cells.
+	Param seconds: wall clock time the phase took, from throughputClock(). */
+void logThroughput(const char *phase, long cellYears, double seconds){
+	char line[256];
+
+	if(seconds > 0){
+		snprintf(line, sizeof line, "%s: %ld cell-years in %.2f s (%.1f cell-years/s)\n",
+		         phase, cellYears, seconds, cellYears / seconds);
+	} else {
+		snprintf(line, sizeof line, "%s: %ld cell-years\n", phase, cellYears);
+	}
+
+	if(logfp && logfp != stdout){
+		fputs(line, logfp);
+	}
+	if(UseProgressBar || logfp == stdout){
+		// Move past the progress bar so it isn't overwritten.
+		if(UseProgressBar){
+			printf("\n");
+		}
+		fputs(line, stdout);
+	}
+}
+
 /* Returns a double between 0 and 100 representing how close the program is to completing a given loop.
  *
  * \param innerLoopIteration is the iteration of the inner loop.
@@ -32,5 +32,7 @@ typedef enum
 /******************** Exported Function(s) ************************/
 
 void logProgress(int iteration, int year, Status status);
+double throughputClock(void);
+void logThroughput(const char *phase, long cellYears, double seconds);
 
 #endif
\ No newline at end of file
@@ -36,9 +36,12 @@
 #include "sw_src/filefuncs.h"
 #include "ST_functions.h"
 #include "sxw_funcs.h"
+#include "ST_scratch.h"
 
 extern
   pcg32_random_t resgroups_rng;
+extern
+  unsigned long indivChanges; /* From ST_indivs.c */
 
 /******** Modular External Function Declarations ***********/
 /* -- truly global functions are declared in functions.h --*/
@@ -54,6 +57,7 @@ void rgroup_Establish(void);
 void rgroup_IncrAges(void);
 void rgroup_PartResources(void);
 void rgroup_ResPartIndiv(void);
+void rgroup_FreePartitionMemory(void);
 void rgroup_DropSpecies(SppIndex sp);
 void rgroup_AddSpecies(GrpIndex rg, SppIndex sp);
 void rgroup_Extirpate(GrpIndex rg);
@@ -64,6 +68,16 @@ void copy_rgroup(const GroupType* src, GroupType* dest);
 static void _res_part_extra(RealF extra, RealF size[]);
 static GroupType *_create(void);
 static void _extra_growth(GrpIndex rg);
+static void _set_grp_res_prop(GrpIndex rg, RealF sumsize);
+static Bool _resort_indivs(GrpIndex rg, const char sort, int n);
+static void _reverse_ties(IndivType **list, int *pos, int n);
+static RealF _partition(const RealF demand[], RealF share[], int n, RealF supply);
+static void _reserve_partition(int n);
+
+/* Work arrays of rgroup_ResPartIndiv() with one element per individual of
+ * a group. They only grow, see _reserve_partition(). */
+static RealF *_demand = NULL, *_share = NULL;
+static int _partitionCapacity = 0;
 static void _add_annual_seedprod(SppIndex sp, RealF lastyear_relsize);
 static RealF _get_annual_maxestab(SppIndex sp);
 static RealF _add_annuals(const GrpIndex rg, const SppIndex sp, const RealF lastyear_relsize);
@@ -346,7 +360,8 @@ static void _res_part_extra(RealF extra, RealF size[]) {
  * 
  * This function iterates across all groups and individuals. Species distinctions
  * within a group are ignored. Partitioning is proportional to the size of individuals, 
- * so larger individuals receive more resources.
+ * so larger individuals receive more resources. Each pass over a group is a single
+ * _partition() over its size-ordered individuals.
  * 
  * Note that this function also partitions [extra resources](\ref _res_part_extra())
  * 
@@ -362,18 +377,16 @@ static void _res_part_extra(RealF extra, RealF size[]) {
 void rgroup_ResPartIndiv(void) {
     GrpIndex rg;
     GroupType *g; /* shorthand for RGroup[rg] */
-    SppIndex sp;
-    Int j;
-    IndivType **indivs, /* dynamic array of indivs in RGroup[rg] */
+    IndivType **indivs, /* size-ordered indivs in RGroup[rg], owned by the group */
             *ndv; /* shorthand for the current indiv */
     IntS numindvs, n;
-    RealF base_rem = 0., /* remainder of resource after allocating to an indiv */
+    RealF base_rem = 0., /* remainder of resource after allocating to all indivs */
             xtra_obase = 0., /* summed extra resources across all groups */
             *size_base, /* biomass of the functional group */
     		*size_obase; /* biomass of functional groups that can use extra resources */
 
-    size_base = (RealF *)Mem_Calloc(SuperGlobals.max_rgroups, sizeof(RealF), "rgroup_ResPartIndiv");
-    size_obase = (RealF *)Mem_Calloc(SuperGlobals.max_rgroups, sizeof(RealF), "rgroup_ResPartIndiv");
+    size_base = (RealF *)scratch_Alloc(SuperGlobals.max_rgroups, sizeof(RealF), "rgroup_ResPartIndiv");
+    size_obase = (RealF *)scratch_Alloc(SuperGlobals.max_rgroups, sizeof(RealF), "rgroup_ResPartIndiv");
     
     /* Divide each group's normal resources to individuals */
     ForEachGroup(rg) {
@@ -381,31 +394,24 @@ void rgroup_ResPartIndiv(void) {
         if (g->est_count == 0)
             continue;
 
-        /* Allocate the temporary group-oriented arrays */
-        indivs = RGroup_GetIndivs(rg, SORT_D, &numindvs);
-
-        /* Set resources available at the group level to base_rem */
-        base_rem = g->res_avail;
-        //printf("g->res_avail = %f\n, Group = %s \n", RGroup[rg]->name, g->res_avail);
-
-        ForEachEstSpp(sp, rg, j) {
-            for (n = 0; n < numindvs; n++) {
-                ndv = indivs[n];
+        /* Get the individuals of the group from largest to smallest */
+        indivs = RGroup_SortedIndivs(rg, SORT_D, &numindvs);
+        _reserve_partition(numindvs);
 
-                /* Calculate resources required for each individual in terms of biomass */
-                ndv->res_required = ndv->relsize * Species [sp]->mature_biomass;
-                //printf("ndv->res_required = %f\n, Species = %s \n", Species[sp]->name, ndv->res_required);
-                //printf("ndv->relsize = %f\n, Species = %s \n", Species[sp]->name, ndv->relsize);
+        /* Calculate resources required for each individual in terms of biomass */
+        for (n = 0; n < numindvs; n++) {
+            ndv = indivs[n];
+            ndv->res_required = ndv->relsize * Species[ndv->myspecies]->mature_biomass;
+            _demand[n] = ndv->res_required;
+        }
 
-                /* Calculate resources available for each individual based on res_required */
-                ndv->res_avail = fmin(ndv->res_required, base_rem);
-                //printf("ndv->res_avail = %f\n", ndv->res_avail);
+        /* Fill the individuals' requirements from the group's resources, largest
+         * individual first, until the resources run out. base_rem is what is left. */
+        base_rem = _partition(_demand, _share, numindvs, g->res_avail);
+        //printf("base_rem = %f\n", base_rem);
 
-                /* Remaining extra resource for each individual (if any) */
-                base_rem = fmax(base_rem - ndv->res_avail, 0.);
-                //printf("base_rem = %f\n", base_rem);
-            }
-        } /* end ForEachEstSpp() */
+        for (n = 0; n < numindvs; n++)
+            indivs[n]->res_avail = _share[n];
 
         /* Sum "extra" resources for all functional groups */
         xtra_obase += base_rem;
@@ -417,8 +423,6 @@ void rgroup_ResPartIndiv(void) {
         size_obase[rg] = (g->use_extra_res) ? size_base[rg] : 0.;
         //printf("size_obase = %f\n", size_obase[rg]);
 
-        Mem_Free(indivs);
-
     } /* end ForEachGroup() */
 
     /* Assign extra resources to functional groups that can use them */
@@ -442,55 +446,109 @@ void rgroup_ResPartIndiv(void) {
 
         //printf("g->res_extra = %f\n, RGroup= %s \n", RGroup[rg]->name, g->res_extra);
 
-        /* Allocate the temporary group-oriented arrays */
-        indivs = RGroup_GetIndivs(rg, SORT_D, &numindvs);
+        /* Get the individuals of the group from largest to smallest */
+        indivs = RGroup_SortedIndivs(rg, SORT_D, &numindvs);
+        _reserve_partition(numindvs);
 
-        ForEachEstSpp(sp, rg, j) {
+        /* Individuals that already have the resources they require get no extra;
+         * the others need the difference between what they require and what
+         * they were assigned through partitioning of normal resources */
+        for (n = 0; n < numindvs; n++) {
+            ndv = indivs[n];
+            _demand[n] = GE(ndv->res_avail, ndv->res_required) ? 0. : ndv->res_required - ndv->res_avail;
+        }
 
-            /* Compute PR at the individual level and assign extra resources */
-            for (n = 0; n < numindvs; n++) {
-                ndv = indivs[n];
-
-                    //printf("ndv->res_avail before  = %f\n", ndv->res_avail);
-
-                    /* If individuals already have the resources they require do 
-                     * not assign extra */
-                    if (GE(ndv->res_avail, ndv->res_required)) {
-                        ndv->res_extra = 0.0;
-                    }
-                    
-                    /* Assign extra resource as the difference of what is required
-                    * by the individual using what was assigned to the individual 
-                    * through partitioning of normal resources */
-                    else {
-                        ndv->res_extra = fmin(ndv->res_required - ndv->res_avail, g->res_extra);
-                        //printf("ndv->res_required = %f\n", ndv->res_required);
-                        //printf("ndv->res_avail = %f\n", ndv->res_avail);
-                        //printf("ndv->res_extra = %f\n", ndv->res_extra);
-
-                        /* Updated resources available for each individual to include extra */
-                        ndv->res_avail += ndv->res_extra;
-                        //printf("ndv->res_avail after = %f\n", ndv->res_avail);
-
-                        /* Remaining extra resources to be used for superfluous growth */
-                        g->res_extra = fmax(g->res_extra - ndv->res_extra, 0.);
-                        //printf("g->res_extra in loop = %f\n,Group = %s \n",RGroup[rg]->name,  g->res_extra);
-                    }
-
-                /* Calculate the PR value, or dflt to 100. Used in growth module */
-                ndv->pr = GT(ndv->res_avail, 0.) ? ndv->res_required / ndv->res_avail : 100.;
-                //printf("ndv->pr  = %f\n", ndv->pr);
-            }
-        } /* end ForEachEstSpp() */
+        /* Remaining extra resources to be used for superfluous growth */
+        g->res_extra = _partition(_demand, _share, numindvs, g->res_extra);
 
-        //printf("g->res_extra after = %f\n,Group = %s \n",RGroup[rg]->name,  g->res_extra);
+        for (n = 0; n < numindvs; n++) {
+            ndv = indivs[n];
 
-        Mem_Free(indivs);
+            /* Updated resources available for each individual to include extra */
+            ndv->res_extra = _share[n];
+            ndv->res_avail += ndv->res_extra;
+
+            /* Calculate the PR value, or dflt to 100. Used in growth module */
+            ndv->pr = GT(ndv->res_avail, 0.) ? ndv->res_required / ndv->res_avail : 100.;
+            //printf("ndv->pr  = %f\n", ndv->pr);
+        }
+
+        //printf("g->res_extra after = %f\n,Group = %s \n",RGroup[rg]->name,  g->res_extra);
 
     } /* end ForEachGroup() */
-    
-    Mem_Free(size_obase);
-    Mem_Free(size_base);
+}
+
+/**
+ * \brief Hand out a supply of resources to individuals in order.
+ * 
+ * This is the "cup" method of COMMENT 3: every individual takes what it
+ * demands as long as any supply is left, so
+ * share[i] = min(demand[i], max(supply - demand[0] - ... - demand[i-1], 0)).
+ * 
+ * Written as a clamped prefix sum. The running total of the demands is the
+ * only serial dependency; the loop that clamps the shares has none, so the
+ * compiler can vectorize it.
+ * 
+ * \param demand what each of the n individuals requires, all >= 0.
+ * \param share what each individual receives is returned here.
+ * \param n number of individuals.
+ * \param supply the resources to hand out.
+ * 
+ * \return The supply that is left after every demand has been met, or 0.
+ * 
+ * \ingroup RGROUP_PRIVATE
+ */
+static RealF _partition(const RealF demand[], RealF share[], int n, RealF supply) {
+    int i;
+    RealF left, used = 0.;
+
+    /* share[i] first holds the summed demand of the individuals before i */
+    for (i = 0; i < n; i++) {
+        share[i] = used;
+        used += demand[i];
+    }
+
+    for (i = 0; i < n; i++) {
+        left = supply - share[i];
+        left = (left > 0.) ? left : 0.;
+        share[i] = (demand[i] < left) ? demand[i] : left;
+    }
+
+    left = supply - used;
+    return (left > 0.) ? left : 0.;
+}
+
+#ifdef STDEBUG
+RealF (*partition)(const RealF demand[], RealF share[], int n, RealF supply) = _partition;
+#endif
+
+/**
+ * \brief Make sure the work arrays of rgroup_ResPartIndiv() hold n elements.
+ * 
+ * \ingroup RGROUP_PRIVATE
+ */
+static void _reserve_partition(int n) {
+    if (n <= _partitionCapacity)
+        return;
+
+    Mem_Free(_demand);
+    Mem_Free(_share);
+    _partitionCapacity = max(n, 2 * _partitionCapacity);
+    _demand = (RealF *) Mem_Calloc(_partitionCapacity, sizeof(RealF), "_reserve_partition: demand");
+    _share = (RealF *) Mem_Calloc(_partitionCapacity, sizeof(RealF), "_reserve_partition: share");
+}
+
+/**
+ * \brief Free the work arrays of rgroup_ResPartIndiv().
+ * 
+ * \ingroup RGROUP
+ */
+void rgroup_FreePartitionMemory(void) {
+    Mem_Free(_demand);
+    Mem_Free(_share);
+    _demand = NULL;
+    _share = NULL;
+    _partitionCapacity = 0;
 }
 
 /**
@@ -498,7 +556,9 @@ void rgroup_ResPartIndiv(void) {
  *        and [individuals](\ref INDIVIDUAL).
  * 
  * This function will loop though all groups in \ref RGroup, all species in \ref Species
- * and all individuals in the linked lists.
+ * and all individuals in the linked lists. Normal growth is computed for all
+ * individuals of a species first; the few clonal individuals that regrow
+ * vegetatively are fixed up in the pass that updates the sizes.
  * 
  * \sideeffect  [ndv](\ref IndivType)->relsize is modified.\n
  *              [ndv](\ref IndivType)->normal_growth is set.\n
@@ -512,17 +572,17 @@ void rgroup_ResPartIndiv(void) {
  */
 void rgroup_Grow(void) {
     IntU j;
+    int i, n;
     GrpIndex rg;
     SppIndex sp;
     GroupType *g;
     SpeciesType *s;
     const RealF OPT_SLOPE = .05; /* from Coffin and Lauenroth 1990, EQN 5 */
-    RealF growth1, /* growth of one individual */
-            sppgrowth, /* sum of growth for a species' indivs */
-            rate1, /* rate of growth for an individual */
-            tgmod, /* temperature growth factor modifier */
-            gmod; /* growth factor modifier */
-    IndivType *ndv; /* temp pointer for current indiv */
+    RealF tgmod, /* temperature growth factor modifier */
+            gmod, /* growth factor modifier */
+            intrin_rate; /* intrinsic growth rate of the current species */
+    IndivType *indivs, /* the individuals of the current species */
+            *ndv; /* temp pointer for current indiv */
 
     ForEachGroup(rg) {
         g = RGroup[rg];
@@ -538,55 +598,58 @@ void rgroup_Grow(void) {
         ForEachEstSpp(sp, rg, j) {
             s = Species[sp];
 
-            sppgrowth = 0.0;
             if (!Species[sp]->allow_growth)
                 continue;
 
             /* Modify growth rate by temperature calculated in Env_Generate() */
             tgmod = (s->tempclass == NoSeason) ? 1. : Env->temp_reduction[s->tempclass];
-
-            /* Now increase size of the individual plants of current species */
-            ForEachIndiv(ndv, s) {
+            intrin_rate = s->intrin_rate;
+
+            /* The individuals as an array in list order. This loop is not
+             * vectorized: gcc 12 reports control flow for the PR test, and
+             * even with that test written as a select it finds no vector
+             * type for the strided IndivType fields. There is no AVX2 path
+             * for the same reason; it would need gathers and scatters. */
+            indivs = Indiv_Pack(s, &n);
+            for (i = 0; i < n; i++) {
                 /* Growth rate (gmod) initially set to 0.95. Values for gmod range
                 between 0.05 and 0.95 similar to Coffin and Lauenroth 1990 */
                 gmod = 1.0 - OPT_SLOPE;
                 
                 /* Reduction in gmod if PR > 1 (resource limitation) */
-                if (GT(ndv->pr, 1.0))
-                    gmod /= ndv->pr;
+                if (GT(indivs[i].pr, 1.0))
+                    gmod /= indivs[i].pr;
                 
                 /* Further modification of gmod based on this year's temperature */
                 gmod *= tgmod;
-                
+
+                /* Normal growth: modifier times optimal growth rate (EQN 1)
+                 * in Coffin and Lauenroth 1990 */
+                indivs[i].growthrate = gmod * intrin_rate * (1.0 - indivs[i].relsize);
+
+                // Save the increment in size due to normal resources for use in the grazing module.
+                indivs[i].normal_growth = indivs[i].growthrate * indivs[i].relsize;
+            }
+
+            /* Now increase size of the individual plants of current species */
+            for (i = 0; i < n; i++) {
+                ndv = &indivs[i];
+
                 /* For clonal species, if the individual appears killed it was 
                  * reduced due to low resources last year. It can reproduce vegetatively 
-                 * this year but couldn't last year. */
+                 * this year but couldn't last year. The random numbers are drawn
+                 * in list order, as before. */
                 if (ndv->killed && RandUni(&resgroups_rng) < ndv->prob_veggrow) {
-                    growth1 = s->relseedlingsize * RandUniIntRange(1, s->max_vegunits, &resgroups_rng);
-                    rate1 = growth1 / ndv->relsize;
+                    ndv->normal_growth = s->relseedlingsize * RandUniIntRange(1, s->max_vegunits, &resgroups_rng);
+                    ndv->growthrate = ndv->normal_growth / ndv->relsize;
                     ndv->killed = FALSE;
-                    //printf("growth1 killed  = %f\n", growth1);
-                } else {
-                    /* Normal growth: modifier times optimal growth rate (EQN 1)
-                     * in Coffin and Lauenroth 1990 */
-                    rate1 = gmod * s->intrin_rate * (1.0 - ndv->relsize);
-                    growth1 = rate1 * ndv->relsize;
+                    //printf("growth1 killed  = %f\n", ndv->normal_growth);
                 }
-                //printf("growth1  = %f\n", growth1);
                 //printf("old ndv->relsize  = %f\n,Species = %s \n", Species[sp]->name, ndv->relsize);
 
-                ndv->relsize += growth1;
+                Indiv_SetRelsize(ndv, ndv->relsize + ndv->normal_growth);
                 //printf("new ndv->relsize  = %f\n, Species = %s \n", Species[sp]->name,ndv->relsize);
-
-		        // Save the increment in size due to normal resources for use in the grazing module.
-		        ndv->normal_growth = growth1;
-
-                ndv->growthrate = rate1;
-
-                sppgrowth += growth1;
-                //printf("sppgrowth = %f\n, Species = %s \n", Species[sp]->name,sppgrowth);
-
-            } /*END ForEachIndiv */
+            }
 
         } /* ENDFOR j (for each species)*/
         
@@ -619,12 +682,14 @@ void rgroup_Grow(void) {
  * \ingroup RGROUP_PRIVATE
  */
 static void _extra_growth(GrpIndex rg) {
-    Int j;
-    RealF extra_ndv, indivpergram;
+    Int j, k;
+    RealF extra_ndv, indivpergram, sumsize = 0.0;
+    double others;
+    Bool any = FALSE;
     GroupType *g;
     SpeciesType *s;
     IndivType *ndv;
-    SppIndex sp;
+    SppIndex sp, sp2;
 
     g = RGroup[rg];
 
@@ -644,11 +709,26 @@ static void _extra_growth(GrpIndex rg) {
         /* Calculate the proportion of maximum species biomass that is represented by 1 unit */
         indivpergram = 1.0 / s->mature_biomass;
 
+        /* The group's size includes the extra growth handed out so far, so it
+         * changes from one individual to the next, but only through this
+         * species. The other species are summed once, as getRGroupRelsize()
+         * would sum them. */
+        others = 0.0;
+        ForEachEstSpp(sp2, rg, k) {
+            if (sp2 != sp)
+                others += getSpeciesRelsize(sp2);
+        }
+
         ForEachIndiv(ndv, s) {
             /* Clear extra for each individual*/
             extra_ndv = 0.0;
 
-            RGroup_Update_GrpResProp(rg);
+            /* Only this individual's share is needed here; the others are set
+             * once after the loop. */
+            sumsize = (RealF) (others + getSpeciesRelsize(sp));
+            any = TRUE;
+            ndv->grp_res_prop = ndv->relsize / sumsize;
+
             /* Calculate the extra resource available to each individual based on size */
             ndv->res_extra = ndv->grp_res_prop * g->res_extra;
             //printf("ndv->res_extra = %f\n,Species = %s \n", Species[sp]->name, ndv->res_extra);
@@ -670,8 +750,16 @@ static void _extra_growth(GrpIndex rg) {
         } /*END ForEachIndiv */
 
     } /* ENDFOR j (for each species)*/
+
+    /* Leave every individual with the share it had when the last one was served */
+    if (any)
+        _set_grp_res_prop(rg, sumsize);
 }
 
+#ifdef STDEBUG
+void (*extra_growth)(GrpIndex rg) = _extra_growth;
+#endif
+
 
 /**
  * \brief Establishes individuals in all species in all resource groups.
@@ -860,9 +948,6 @@ RealF getRGroupRelsize(GrpIndex rg){
  */
 void RGroup_Update_GrpResProp(GrpIndex rg)
 {
-	Int n;
-	IndivType **indivs;
-	IntS numindvs;
 	RealF sumsize = 0.0;
 
 	/* first get group's relative size adjusted for num indivs */
@@ -874,19 +959,38 @@ void RGroup_Update_GrpResProp(GrpIndex rg)
         RGroup[rg]->name, sumsize, RGroup[rg]->est_count, RGroup[rg]->relsize);
     */
 
-	numindvs = 0; // set to 0 so no problems passing to function
-	/* compute the contribution of each indiv to the group's size */
-	indivs = RGroup_GetIndivs(rg, SORT_0, &numindvs);
-	for (n = 0; n < numindvs; n++)
-		indivs[n]->grp_res_prop = indivs[n]->relsize / sumsize;
-
-	Mem_Free(indivs);
+	_set_grp_res_prop(rg, sumsize);
 
 	/* double check some assumptions */
 	if (RGroup[rg]->est_count < 0)
 		RGroup[rg]->est_count = 0;
 }
 
+/**
+ * \brief Set grp_res_prop of every individual in \ref RGroup[rg] for a group
+ *        of the given size.
+ * 
+ * Walks the lists of the established species directly, in the same order
+ * as RGroup_SortedIndivs() lists them before sorting, without allocating a
+ * list of pointers.
+ * 
+ * \param rg = index in \ref RGroup of the resource group.
+ * \param sumsize = the relative size of the group.
+ * 
+ * \ingroup RGROUP_PRIVATE
+ */
+static void _set_grp_res_prop(GrpIndex rg, RealF sumsize)
+{
+	Int j;
+	SppIndex sp;
+	IndivType *ndv;
+
+	/* compute the contribution of each indiv to the group's size */
+	ForEachEstSpp(sp, rg, j)
+		ForEachIndiv(ndv, Species[sp])
+			ndv->grp_res_prop = ndv->relsize / sumsize;
+}
+
 /**
  * \brief calculates the biomass of a given [resource group](\ref RGroup)
  * 
@@ -1131,6 +1235,9 @@ void copy_rgroup(const GroupType* src, GroupType* dest){
         dest->est_spp[i] = src->est_spp[i];
     }
 
+    /* dest's individuals and est_spp have changed */
+    RGroup_InvalidateSorted(dest);
+
     /* ------------- Copy all fields --------------- */
     dest->depth = src->depth;
     dest->est_annually = src->est_annually;
@@ -1212,45 +1319,202 @@ void RGroup_Kill(GrpIndex rg)
 }
 
 /**
- * \brief Returns an array of all individual in all species in the given group.
+ * \brief Get the individuals of a group sorted by size without allocating.
  * 
- * \param rg in the [index](\ref GrpIndex) of the resource group.
- * \param sort provides the option to sort the individuals based on size.
- *             Use 'a' to sort ascending, 'b' to sort decenting, or 0 to not sort.
- * \param num will be populated with the number of individuals in the array.
+ * The list belongs to the group and is reused. It is only sorted again if
+ * an individual was established, killed, moved or resized since the last
+ * call (see \ref indivChanges), so the two calls per year in
+ * rgroup_ResPartIndiv() share one sort.
  * 
- * \return an array of pointers to all [individuals](\ref IndivType) in the group.
+ * Individuals of the same size are in the order of the lists of the
+ * established species, as Indiv_MergeSortSize() leaves them. Most
+ * individuals keep their rank from one sort to the next, so the list is
+ * first re-sorted from the previous order by _resort_indivs(), and only
+ * sorted from scratch if that gives up.
  * 
- * \sideeffect 
- *     \* num will be populated with the size of the array.
+ * \param rg the index in \ref RGroup of the group.
+ * \param sort SORT_A for ascending or SORT_D for descending order.
+ * \param num the number of individuals in the list is returned here.
  * 
- * \author
- *     Chris Bennett
+ * \return The list of individuals. Do not free it or keep it past the next
+ *         call for this group.
  * 
- * \ingroup RGROUP    
+ * \ingroup RGROUP
  */
-IndivType **RGroup_GetIndivs(GrpIndex rg, const char sort, IntS *num)
+IndivType **RGroup_SortedIndivs(GrpIndex rg, const char sort, IntS *num)
 {
-	IntS j, i = 0;
-	size_t i_size = sizeof(IndivType **);
+	GroupType *g = RGroup[rg];
+	IntS j;
+	int n = 0, i;
 	SppIndex sp;
-	IndivType *ndv, **nlist;
+	IndivType *ndv;
+
+	if (g->sortedAt == indivChanges && g->sortedOrder == sort) {
+		*num = g->sortedCount;
+		return g->sorted;
+	}
 
 	ForEachEstSpp(sp, rg, j)
 		ForEachIndiv(ndv, Species[sp])
-			i++;
-	nlist = Mem_Calloc(i, i_size, "Rgroup_GetIndivs(nlist)");
+			n++;
+
+	if (n > g->sortedCapacity) {
+		Mem_Free(g->sorted);
+		Mem_Free(g->sortScratch);
+		g->sortedCapacity = max(n, 2 * g->sortedCapacity);
+		g->sorted = (IndivType **) Mem_Calloc(g->sortedCapacity, sizeof(IndivType *),
+		                                      "RGroup_SortedIndivs: sorted");
+		g->sortScratch = (IndivType **) Mem_Calloc(g->sortedCapacity, sizeof(IndivType *),
+		                                           "RGroup_SortedIndivs: sortScratch");
+	}
+
+	if (!_resort_indivs(rg, sort, n)) {
+		i = 0;
+		ForEachEstSpp(sp, rg, j)
+			ForEachIndiv(ndv, Species[sp])
+				g->sorted[i++] = ndv;
+
+		Indiv_MergeSortSize(sort, (size_t) n, g->sorted, g->sortScratch);
+	}
+
+	for (i = 0; i < n; i++)
+		g->sorted[i]->sortRank = i;
+
+	g->sortedCount = n;
+	g->sortedOrder = sort;
+	g->sortedAt = indivChanges;
+
+	*num = n;
+	return g->sorted;
+}
+
+/**
+ * \brief Sort the individuals of a group, starting from the order of the
+ *        last sort.
+ * 
+ * Every individual that was in the last list of the group is put back at
+ * its IndivType.sortRank, reversed if the order changed. Individuals that
+ * were not in that list go to the small end, where seedlings belong.
+ * Indiv_ResortSize() then fixes what growth and mortality moved.
+ * 
+ * \param rg the index in \ref RGroup of the group.
+ * \param sort SORT_A for ascending or SORT_D for descending order.
+ * \param n the number of individuals in the group.
+ * 
+ * \return TRUE if \ref RGroup[rg]->sorted holds the sorted list. FALSE if
+ *         there was no last sort to start from or the sort gave up.
+ * 
+ * \ingroup RGROUP_PRIVATE
+ */
+static Bool _resort_indivs(GrpIndex rg, const char sort, int n)
+{
+	GroupType *g = RGroup[rg];
+	int prev = g->sortedCount, nplaced = 0, nnew = 0, p = 0, r, i, k;
+	Bool flip = (Bool) (g->sortedOrder != sort);
+	IntS j;
+	SppIndex sp;
+	IndivType *ndv, **placed, **added;
+	int *placedPos, *addedPos, *pos;
+
+	if (prev == 0 || n == 0
+	    || (g->sortedOrder != SORT_A && g->sortedOrder != SORT_D))
+		return FALSE;
+
+	placed = (IndivType **) scratch_Alloc(prev, sizeof(IndivType *), "_resort_indivs");
+	placedPos = (int *) scratch_Alloc(prev, sizeof(int), "_resort_indivs");
+	added = (IndivType **) scratch_Alloc(n, sizeof(IndivType *), "_resort_indivs");
+	addedPos = (int *) scratch_Alloc(n, sizeof(int), "_resort_indivs");
+	pos = (int *) scratch_Alloc(n, sizeof(int), "_resort_indivs");
 
-	i = 0;
+	/* p counts the position of each individual in the lists of the species */
 	ForEachEstSpp(sp, rg, j)
-		ForEachIndiv(ndv, Species[sp])
-			nlist[i++] = ndv;
+		ForEachIndiv(ndv, Species[sp]) {
+			r = ndv->sortRank;
+			if (r >= 0 && r < prev && flip)
+				r = prev - 1 - r;
+			if (r >= 0 && r < prev && placed[r] == NULL) {
+				placed[r] = ndv;
+				placedPos[r] = p;
+			} else {
+				added[nnew] = ndv;
+				addedPos[nnew++] = p;
+			}
+			p++;
+		}
+
+	k = 0;
+	if (sort == SORT_A)
+		for (i = 0; i < nnew; i++, k++) {
+			g->sorted[k] = added[i];
+			pos[k] = addedPos[i];
+		}
+	for (i = 0; i < prev; i++)
+		if (placed[i] != NULL) {
+			g->sorted[k] = placed[i];
+			pos[k++] = placedPos[i];
+			nplaced++;
+		}
+	if (sort == SORT_D)
+		for (i = 0; i < nnew; i++, k++) {
+			g->sorted[k] = added[i];
+			pos[k] = addedPos[i];
+		}
+
+	/* Individuals of the same size are reversed with the list; turn them
+	 * back into the order of the species lists. */
+	if (flip)
+		_reverse_ties(g->sorted + (sort == SORT_A ? nnew : 0), pos + (sort == SORT_A ? nnew : 0),
+		              nplaced);
+
+	/* Give up once the sort costs about as much as sorting from scratch */
+	return Indiv_ResortSize(sort, (size_t) n, g->sorted, pos, (size_t) (n + 64));
+}
 
-	*num = i;
-	if (i > 0 && sort)
-		Indiv_SortSize(sort, (size_t) i, nlist);
+/**
+ * \brief Reverse every run of individuals of exactly the same size.
+ * 
+ * \param list the individuals.
+ * \param pos their positions, reversed along with them.
+ * \param n the length of list and pos.
+ * 
+ * \ingroup RGROUP_PRIVATE
+ */
+static void _reverse_ties(IndivType **list, int *pos, int n)
+{
+	int start = 0, end, a, b, tp;
+	IndivType *t;
+
+	while (start < n) {
+		end = start + 1;
+		while (end < n && list[end]->relsize == list[start]->relsize)
+			end++;
+		for (a = start, b = end - 1; a < b; a++, b--) {
+			t = list[a];
+			list[a] = list[b];
+			list[b] = t;
+			tp = pos[a];
+			pos[a] = pos[b];
+			pos[b] = tp;
+		}
+		start = end;
+	}
+}
 
-	return nlist;
+/**
+ * \brief Make the next RGroup_SortedIndivs() call for a group rebuild its list.
+ * 
+ * Call this whenever the individuals or established species of a group are
+ * replaced without going through the functions that count \ref indivChanges,
+ * e.g. when a group is copied, restored from a snapshot or read from a
+ * checkpoint.
+ * 
+ * \param g the group.
+ * 
+ * \ingroup RGROUP
+ */
+void RGroup_InvalidateSorted(GroupType *g)
+{
+	g->sortedAt = 0;
 }
 
 #ifdef DEBUG_MEM
@@ -1276,6 +1540,10 @@ void RGroup_SetMemoryRefs( void)
 	{
 		NoteMemoryRef(RGroup[rg]);
 		NoteMemoryRef(RGroup[rg]->kills); /* this is set it params() */
+		if (RGroup[rg]->sorted) {
+			NoteMemoryRef(RGroup[rg]->sorted);
+			NoteMemoryRef(RGroup[rg]->sortScratch);
+		}
 	}
 
 }
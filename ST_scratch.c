@@ -0,0 +1,111 @@
+/**************************************************************************/
+/* ST_scratch.c
+    Function definitions for the scratch arena. See ST_scratch.h for a
+    description.
+
+    The arena is a chain of blocks. When the current block is full a
+    larger one is put in front of it. scratch_Reset() merges a chain into
+    a single block of the combined size, so after the first few years a
+    whole year fits into one block and no memory is allocated at all.
+ */
+/**************************************************************************/
+
+#include <string.h>
+#include "ST_scratch.h"
+#include "sw_src/myMemory.h"
+
+/* Every allocation starts at a multiple of this, which suits any type the
+   model allocates. */
+#define SCRATCH_ALIGN 16
+
+/* Smallest block the arena allocates, in bytes. */
+#define MIN_SCRATCH_BLOCK 65536
+
+struct scratch_block_st
+{
+	char *data;
+	size_t size,                   /* bytes in data */
+	       used;                   /* bytes handed out since the last reset */
+	struct scratch_block_st *prev; /* the block that was full before this one */
+} typedef ScratchBlock;
+
+/*************** Local Function(s). Treat these as private. ***************/
+
+static void _new_block(size_t size, const char *funcname);
+
+/*************************** Local Variable(s) ****************************/
+
+/* The block allocations come from, NULL before the first allocation. */
+static ScratchBlock *_current = NULL;
+
+/* Summed size of all blocks in the chain. */
+static size_t _total = 0;
+
+/*********************** Function Definitions *****************************/
+
+/* Like Mem_Calloc: returns nobjs * size zeroed bytes. The memory is valid
+   until the next scratch_Reset() and must not be passed to Mem_Free. */
+void *scratch_Alloc(size_t nobjs, size_t size, const char *funcname){
+	size_t bytes = nobjs * size;
+	size_t padded = (bytes + SCRATCH_ALIGN - 1) / SCRATCH_ALIGN * SCRATCH_ALIGN;
+	void *p;
+
+	if(!_current || _current->size - _current->used < padded){
+		_new_block(padded, funcname);
+	}
+
+	p = _current->data + _current->used;
+	_current->used += padded;
+	memset(p, 0, bytes);
+	return p;
+}
+
+/* Release everything allocated since the last reset. Called at the end of
+   every simulated year. */
+void scratch_Reset(void){
+	size_t total = _total;
+
+	if(!_current){
+		return;
+	}
+	if(_current->prev){
+		/* This year needed several blocks. Replace them with one that
+		   holds as much, so the next year does not need to allocate. */
+		scratch_Free();
+		_new_block(total, "scratch_Reset");
+	}
+	_current->used = 0;
+}
+
+/* Free all memory of the arena. */
+void scratch_Free(void){
+	ScratchBlock *prev;
+
+	while(_current){
+		prev = _current->prev;
+		Mem_Free(_current->data);
+		Mem_Free(_current);
+		_current = prev;
+	}
+	_total = 0;
+}
+
+/* Put a new block of at least size bytes in front of the chain. It is at
+   least as large as all blocks before it, so the chain stays short. */
+static void _new_block(size_t size, const char *funcname){
+	ScratchBlock *block = (ScratchBlock*) Mem_Calloc(1, sizeof(ScratchBlock), funcname);
+
+	if(size < _total){
+		size = _total;
+	}
+	if(size < MIN_SCRATCH_BLOCK){
+		size = MIN_SCRATCH_BLOCK;
+	}
+
+	block->data = (char*) Mem_Malloc(size, funcname);
+	block->size = size;
+	block->used = 0;
+	block->prev = _current;
+	_current = block;
+	_total += size;
+}
@@ -0,0 +1,29 @@
+/******************************************************************/
+/* ST_scratch.h
+    Defines all exported objects from ST_scratch.c.
+
+    The scratch arena hands out the short-lived arrays of the year
+    loop: lists of individuals to kill, per-group sizes and output
+    buffers. Allocating is a pointer bump and nothing is freed on its
+    own. scratch_Reset() releases everything at the end of every
+    simulated year, so memory from the arena must never be kept
+    longer than the year it was allocated in.
+
+    There is one arena per process. Only one cell is simulated at a
+    time (see ST_context.h), and every cell-year ends with a reset, so
+    the arena never holds memory of two cells at once.
+*/
+/******************************************************************/
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <stddef.h>
+
+/******************** Exported Function(s) ************************/
+
+void *scratch_Alloc(size_t nobjs, size_t size, const char *funcname);
+void scratch_Reset(void);
+void scratch_Free(void);
+
+#endif
@@ -34,7 +34,7 @@ void initDispersalParameters(void)
 	double distanceBetweenPlots; /* distance between the sender and the receiver */
     CellType* sender;
 
-    RandSeed(SuperGlobals.randseed, &dispersal_rng);
+    SimContext_SeedStream(&dispersal_rng, 0, 0, RNG_DISPERSAL);
 
 	/* sender denotes that these loops refer to the cell distributing seeds */
 	for(senderRow = 0; senderCol < grid_Rows; ++senderRow){
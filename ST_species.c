@@ -133,6 +133,14 @@ RealF Species_GetBiomass(SppIndex sp) {
  * 
  * Initial programming by Chris Bennett @ LTER-CSU 6/15/2000.
  * 
+ * The new individuals all start at relseedlingsize, but each one is still
+ * its own IndivType. They do not stay identical for long: resource
+ * partitioning can cut the last of a run of equal individuals short, and
+ * every mortality routine draws its random numbers per individual. A
+ * cohort record would have to be split again in most years, and every
+ * routine that walks, kills, sorts or outputs individuals would have to
+ * understand cohorts.
+ * 
  * \param sp is the index in \ref Species of the species to add individuals to.
  * \param new_indivs is the number of individuals to add.
  * 
@@ -145,7 +153,6 @@ void Species_Add_Indiv(SppIndex sp, Int new_indivs)
 {
 	Int i;
 	GrpIndex rg;
-	RealF newsize = 0.0; /*accumulate total relsize for new indivs*/
 
 	if (0 == new_indivs)
 		return;
@@ -154,6 +161,9 @@ void Species_Add_Indiv(SppIndex sp, Int new_indivs)
 
 	//printf("Inside Species_Add_Indiv() spIndex=%d, new_indivs=%d \n ",sp,  new_indivs);
 
+	/* make room for the whole batch at once */
+	Indiv_Reserve(Species[sp], new_indivs);
+
 	/* add individuals until max indivs */
 	for (i = 1; i <= new_indivs; i++)
 	{
@@ -163,14 +173,10 @@ void Species_Add_Indiv(SppIndex sp, Int new_indivs)
 		}
 
 		Species[sp]->est_count++;
-		newsize += Species[sp]->relseedlingsize;
-		//printf("Loop Index i=%d, Species[sp]->relseedlingsize=%.5f now newsize=%.5f \n ",i,  Species[sp]->relseedlingsize,newsize);
 	}
 
 	/* add species to species group if new*/
 	rgroup_AddSpecies(rg, sp);
-
-	//printf("Inside Species_Add_Indiv() calculated total newsize=%.5f \n ",newsize);
 }
 
 /**
@@ -227,25 +233,22 @@ void species_Update_Estabs(SppIndex sp, IntS num)
  * \return RealF greater than of equal to 0 representing the summed
  *         relsizes of all individuals in \ref Species[sp]
  * 
+ * The sum is kept in \ref Species[sp]->indivs_relsize as individuals
+ * change, so this does not walk the list. check_sizes() verifies it.
+ * 
+ * The running sum adds and subtracts single precision sizes in double
+ * precision. While no size is below 2^-20 and the sum stays below 1024,
+ * every step is exact and the sum equals the one walked over the list.
+ * Otherwise it may differ by rounding, which check_sizes() allows up to
+ * 0.000005.
+ * 
  * \sa getRGroupRelsize()
  * 
  * \ingroup SPECIES
  */
 RealF getSpeciesRelsize(SppIndex sp)
 {
-	IndivType *p = Species[sp]->IndvHead;
-    double sum = 0;
-
-	if(p)
-	{
-    	while(p)
-    	{
-        	sum += p->relsize;
-			p = p->Next;
-    	}
-	}
-
-	return (RealF) (sum + Species[sp]->extragrowth);
+	return (RealF) (Species[sp]->indivs_relsize + Species[sp]->extragrowth);
 }
 
 /**
@@ -282,7 +285,8 @@ SppIndex species_New(void)
 /* Copy one Species' information to another Species. Note that both Species MUST be allocated. */
 void copy_species(const SpeciesType* src, SpeciesType* dest){
 	int i;
-	IndivType *srcIndv, *destIndv, *next;
+	int count = 0;
+	IndivType *srcIndv, *destIndv;
 
 	// Error checking. If src == dest we would just end up loosing the linked list and some other variables.
 	if(!src || src == dest){
@@ -316,6 +320,7 @@ void copy_species(const SpeciesType* src, SpeciesType* dest){
 	dest->estabs = src->estabs;
 	dest->exp_decay = src->exp_decay;
 	dest->extragrowth = src->extragrowth;
+	dest->indivs_relsize = src->indivs_relsize;
 	dest->intrin_rate = src->intrin_rate;
 	dest->isclonal = src->isclonal;
 	dest->lastyear_relsize = src->lastyear_relsize;
@@ -356,18 +361,19 @@ void copy_species(const SpeciesType* src, SpeciesType* dest){
 
 	/* ------------- DEEP Copy linked list ---------------- */
 	// Destroy the old linked list
-	destIndv = dest->IndvHead;
-	while(destIndv){
-		next = destIndv->Next;
-		Mem_Free(destIndv);
-		destIndv = next;
+	Indiv_Clear(dest);
+
+	// Make room for every individual so that none of them moves while the list is built.
+	for(srcIndv = src->IndvHead; srcIndv; srcIndv = srcIndv->Next){
+		count++;
 	}
+	Indiv_Reserve(dest, count);
 
 	srcIndv = src->IndvHead;
 	// If there is a list at all.
 	if(srcIndv){
 		// Allocate a new individual
-		destIndv = (IndivType*) Mem_Calloc(1, sizeof(IndivType), "copy_species: individual");
+		destIndv = Indiv_Alloc(dest);
 		// This individual is the head of the list
 		dest->IndvHead = destIndv;
 		// Copy the individual information across
@@ -379,7 +385,7 @@ void copy_species(const SpeciesType* src, SpeciesType* dest){
 			// Move to the next individual in src
 			srcIndv = srcIndv->Next;
 			// Allocate the next entry in dest.
-			destIndv->Next = (IndivType*) Mem_Calloc(1, sizeof(IndivType), "copy_species: individual");
+			destIndv->Next = Indiv_Alloc(dest);
 			// Doubly link the list before moving on.
 			destIndv->Next->Prev = destIndv;
 			// Move to the new entry
@@ -646,18 +652,13 @@ void Species_SetMemoryRefs( void)
 
 	 */
 	SppIndex sp;
-	IndivType *p;
 
 	ForEachSpecies(sp)
 	{
 		NoteMemoryRef(Species[sp]);
 		NoteMemoryRef(Species[sp]->kills);
-		p = Species[sp]->IndvHead;
-		while (p)
-		{
-			NoteMemoryRef(p);
-			p = p->Next;
-		}
+		if (Species[sp]->indivs)
+			NoteMemoryRef(Species[sp]->indivs);
 	}
 
 }
@@ -50,9 +50,23 @@ StatType *_Dist, *_Ppt, *_Temp,
 FireStatsType *_Gwf;
 
 /*************** Local Function Declarations ***************/
+/** \brief What _transfer_accumulators() does with each accumulator.
+ * \ingroup STATISTICS_PRIVATE
+ */
+typedef enum {
+  TRANSFER_WRITE, /* write to the file */
+  TRANSFER_READ,  /* overwrite with the contents of the file */
+  TRANSFER_MERGE, /* combine with the contents of the file */
+  TRANSFER_CLEAR  /* zero; the file is not used */
+} TransferMode;
+
 static void _init( void);
 static RealF _get_avg( struct accumulators_st *p);
 static RealF _get_std( struct accumulators_st *p);
+static Bool _transfer_accumulators(FILE *f, TransferMode mode);
+static Bool _transfer(FILE *f, struct accumulators_st *p, size_t count, TransferMode mode);
+static Bool _transfer_counts(FILE *f, int *counts, size_t count, TransferMode mode);
+static void _combine(struct accumulators_st *p, const struct accumulators_st *v);
 
 /** \brief A macro for collecting statistics.
  * 
@@ -396,6 +410,247 @@ void stat_Copy_Accumulators(StatType* newDist, StatType* newPpt, StatType* newTe
   firsttime = firstTime;
 }
 
+/**
+ * \brief Write the loaded accumulators to a binary file.
+ * 
+ * Only the accumulators requested in bmassflags.in and mortflags.in are
+ * written, in a fixed order. The file can be read back with
+ * \ref stat_Read_Accumulators by a process that read the same inputs.
+ * 
+ * \param f is a file opened for binary writing.
+ * 
+ * \return TRUE on success, FALSE if writing failed.
+ * 
+ * \sa _write_cell_shard() in ST_grid.c, which writes one block per cell.
+ * 
+ * \ingroup STATISTICS
+ */
+Bool stat_Write_Accumulators(FILE *f) {
+  if (firsttime) {
+    firsttime = FALSE;
+    _init();
+  }
+  return _transfer_accumulators(f, TRANSFER_WRITE);
+}
+
+/**
+ * \brief Overwrite the loaded accumulators with the contents of a binary
+ *        file written by \ref stat_Write_Accumulators.
+ * 
+ * \param f is a file opened for binary reading.
+ * 
+ * \return TRUE on success, FALSE if the file ended early or could not be
+ *         read.
+ * 
+ * \ingroup STATISTICS
+ */
+Bool stat_Read_Accumulators(FILE *f) {
+  if (firsttime) {
+    firsttime = FALSE;
+    _init();
+  }
+  return _transfer_accumulators(f, TRANSFER_READ);
+}
+
+/**
+ * \brief Combine the loaded accumulators with the contents of a binary
+ *        file written by \ref stat_Write_Accumulators.
+ * 
+ * Afterwards the accumulators describe the observations of both. Merging
+ * the accumulators of one iteration at a time, in iteration order, gives
+ * exactly the values that collecting those iterations in one process
+ * gives.
+ * 
+ * \param f is a file opened for binary reading.
+ * 
+ * \return TRUE on success, FALSE if the file ended early or could not be
+ *         read.
+ * 
+ * \sa workers_RunIterations() in ST_workers.c
+ * 
+ * \ingroup STATISTICS
+ */
+Bool stat_Merge_Accumulators(FILE *f) {
+  if (firsttime) {
+    firsttime = FALSE;
+    _init();
+  }
+  return _transfer_accumulators(f, TRANSFER_MERGE);
+}
+
+/**
+ * \brief Zero every requested accumulator.
+ * 
+ * \ingroup STATISTICS
+ */
+void stat_Clear_Accumulators(void) {
+  if (firsttime) {
+    firsttime = FALSE;
+    _init();
+  }
+  _transfer_accumulators(NULL, TRANSFER_CLEAR);
+}
+
+/**
+ * \brief Write, read, merge or clear every requested accumulator.
+ * 
+ * The conditions and array sizes mirror _init() so that reading and writing
+ * always agree on the layout.
+ * 
+ * \param f is the file to transfer to or from.
+ * \param mode is the \ref TransferMode applied to every accumulator.
+ * 
+ * \return FALSE if any transfer failed.
+ * 
+ * \ingroup STATISTICS_PRIVATE
+ */
+static Bool _transfer_accumulators(FILE *f, TransferMode mode) {
+  SppIndex sp;
+  GrpIndex rg;
+  Bool ok = TRUE;
+
+  if (BmassFlags.dist)
+    ok = ok && _transfer(f, _Dist->s, SuperGlobals.runModelYears, mode);
+  if (BmassFlags.ppt)
+    ok = ok && _transfer(f, _Ppt->s, SuperGlobals.runModelYears, mode);
+  if (BmassFlags.tmp)
+    ok = ok && _transfer(f, _Temp->s, SuperGlobals.runModelYears, mode);
+
+  if (BmassFlags.grpb) {
+    ForEachGroup(rg) {
+      ok = ok && _transfer(f, _Grp[rg].s, SuperGlobals.runModelYears, mode);
+      if (BmassFlags.size)
+        ok = ok && _transfer(f, _Gsize[rg].s, SuperGlobals.runModelYears, mode);
+      if (BmassFlags.pr)
+        ok = ok && _transfer(f, _Gpr[rg].s, SuperGlobals.runModelYears, mode);
+    }
+    if (BmassFlags.wildfire || BmassFlags.prescribedfire) {
+      ok = ok && _transfer_counts(f, _Gwf->wildfire, SuperGlobals.runModelYears, mode);
+      ForEachGroup(rg)
+        ok = ok && _transfer_counts(f, _Gwf->prescribedFire[rg], SuperGlobals.runModelYears, mode);
+    }
+  }
+
+  if (MortFlags.group) {
+    ForEachGroup(rg) {
+      ok = ok && _transfer(f, _Gestab[rg].s, 1, mode);
+      ok = ok && _transfer(f, _Gmort[rg].s, GrpMaxAge(rg), mode);
+    }
+  }
+
+  if (BmassFlags.sppb) {
+    ForEachSpecies(sp) {
+      ok = ok && _transfer(f, _Spp[sp].s, SuperGlobals.runModelYears, mode);
+      if (BmassFlags.indv)
+        ok = ok && _transfer(f, _Indv[sp].s, SuperGlobals.runModelYears, mode);
+    }
+  }
+
+  if (MortFlags.species) {
+    ForEachSpecies(sp) {
+      ok = ok && _transfer(f, _Sestab[sp].s, 1, mode);
+      ok = ok && _transfer(f, _Smort[sp].s, SppMaxAge(sp), mode);
+    }
+  }
+
+  if (UseSeedDispersal && UseGrid) {
+    ForEachSpecies(sp)
+      ok = ok && _transfer(f, _Sreceived[sp].s, SuperGlobals.runModelYears, mode);
+  }
+
+  return ok;
+}
+
+/**
+ * \brief Apply mode to count accumulators.
+ * 
+ * \return TRUE if all elements were transferred.
+ * 
+ * \ingroup STATISTICS_PRIVATE
+ */
+static Bool _transfer(FILE *f, struct accumulators_st *p, size_t count, TransferMode mode) {
+  struct accumulators_st v;
+  size_t i;
+
+  switch (mode) {
+    case TRANSFER_WRITE:
+      return (Bool) (fwrite(p, sizeof(struct accumulators_st), count, f) == count);
+    case TRANSFER_READ:
+      return (Bool) (fread(p, sizeof(struct accumulators_st), count, f) == count);
+    case TRANSFER_MERGE:
+      for (i = 0; i < count; i++) {
+        if (fread(&v, sizeof(struct accumulators_st), 1, f) != 1)
+          return FALSE;
+        _combine(&p[i], &v);
+      }
+      return TRUE;
+    case TRANSFER_CLEAR:
+    default:
+      memset(p, 0, sizeof(struct accumulators_st) * count);
+      return TRUE;
+  }
+}
+
+/**
+ * \brief Apply mode to count event counts. Merging adds them.
+ * 
+ * \return TRUE if all elements were transferred.
+ * 
+ * \ingroup STATISTICS_PRIVATE
+ */
+static Bool _transfer_counts(FILE *f, int *counts, size_t count, TransferMode mode) {
+  int v;
+  size_t i;
+
+  switch (mode) {
+    case TRANSFER_WRITE:
+      return (Bool) (fwrite(counts, sizeof(int), count, f) == count);
+    case TRANSFER_READ:
+      return (Bool) (fread(counts, sizeof(int), count, f) == count);
+    case TRANSFER_MERGE:
+      for (i = 0; i < count; i++) {
+        if (fread(&v, sizeof(int), 1, f) != 1)
+          return FALSE;
+        counts[i] += v;
+      }
+      return TRUE;
+    case TRANSFER_CLEAR:
+    default:
+      memset(counts, 0, sizeof(int) * count);
+      return TRUE;
+  }
+}
+
+/**
+ * \brief Add the observations summarized by v to p.
+ * 
+ * A single observation is added with \ref _collect_add so that merging
+ * iterations one by one reproduces serial collection bit for bit. Larger
+ * sets are combined with the pairwise update of Chan, Golub and LeVeque.
+ * 
+ * \ingroup STATISTICS_PRIVATE
+ */
+static void _combine(struct accumulators_st *p, const struct accumulators_st *v) {
+  double delta;
+  unsigned long n;
+
+  if (v->nobs == 0)
+    return;
+
+  if (p->nobs == 0) {
+    _copy_over(p, v);
+  } else if (v->nobs == 1) {
+    _collect_add(p, v->ave);
+  } else {
+    n = p->nobs + v->nobs;
+    delta = v->ave - p->ave;
+    p->ave += delta * v->nobs / n;
+    p->sum_dif_sqr += v->sum_dif_sqr + delta * delta * p->nobs * v->nobs / n;
+    p->nobs = n;
+    p->sd = final_running_sd(p->nobs, p->sum_dif_sqr);
+  }
+}
+
 /***********************************************************/
 void stat_free_mem( void ) {
 	//frees memory allocated in this module
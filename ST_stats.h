@@ -11,6 +11,7 @@
 #ifndef STATS_STRUCT_DEF
 #define STATS_STRUCT_DEF
 
+#include <stdio.h>
 #include "ST_defines.h"
 
 /* Basic struct that holds average, sum of differences squared, standard deviation
@@ -47,6 +48,10 @@ void stat_Copy_Accumulators(StatType* newDist, StatType* newPpt, StatType* newTe
                             StatType* newGsize, StatType* newGpr, StatType* newGmort, StatType* newGestab, 
                             StatType* newSpp, StatType* newIndv, StatType* newSmort, StatType* newSestab, 
                             StatType* newSrecieved, FireStatsType* newGwf, Bool firstTime);
+Bool stat_Write_Accumulators(FILE *f);
+Bool stat_Read_Accumulators(FILE *f);
+Bool stat_Merge_Accumulators(FILE *f);
+void stat_Clear_Accumulators(void);
 void make_header( char *buf);
 void make_header_with_std( char *buf);
 
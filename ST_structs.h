@@ -80,6 +80,10 @@ struct indiv_st {
        /** \brief set when killed; 0 if not clonal.
         * \sa indiv_Kill_Partial() */
        prob_veggrow;
+      /** \brief Position in the size-ordered list of its group when that list
+       * was last built, or -1. RGroup_SortedIndivs() starts the next sort from
+       * this order. */
+  int sortRank;
        /** \brief Allows for a doubly-linked list of individuals. Implemented in \ref Species.
         * \sa Species */
   struct indiv_st *Next, 
@@ -174,6 +178,25 @@ struct species_st {
       /** \brief Head of a doubly-linked list of all individuals of this species. 
        * \sa indiv_st*/
   struct indiv_st *IndvHead;
+      /** \brief Contiguous storage of the individuals in IndvHead, in list order after
+       * each compaction. Only ST_indivs.c allocates from it.
+       * \sa Indiv_Alloc() */
+  struct indiv_st *indivs;
+      /** \brief The array the next compaction copies indivs into. The two are swapped
+       * afterwards, so neither is freed while the species keeps its size. */
+  struct indiv_st *indivSpare;
+      /** \brief Number of slots in indivs. */
+  int indivCapacity,
+      /** \brief Number of slots in indivSpare. */
+      indivSpareCapacity,
+      /** \brief Slots of indivs handed out since the last compaction, dead ones included. */
+      indivUsed;
+      /** \brief TRUE if indivs holds exactly the individuals of IndvHead, in list order.
+       * \sa Indiv_Pack() */
+  Bool indivsInOrder;
+      /** \brief Summed relsize of the individuals in IndvHead. Kept up to date by
+       * Indiv_SetRelsize() and _delete() so getSpeciesRelsize() needs no walk of the list. */
+  double indivs_relsize;
       /** \brief Seed dispersal only- whether to allow growth for the current year.
        * \sa ST_seedDispersal.c */
   Bool allow_growth,
@@ -400,6 +423,20 @@ struct resourcegroup_st {
       /** \brief Rooting depth class.
        * \sa DepthClass */
   DepthClass depth;
+      /** \brief The individuals of this group sorted by size. Reused by
+       * RGroup_SortedIndivs() until an individual changes. */
+  struct indiv_st **sorted,
+      /** \brief Scratch space for sorting sorted. */
+                  **sortScratch;
+      /** \brief Number of individuals in sorted. */
+  int sortedCount,
+      /** \brief Room in sorted and sortScratch. */
+      sortedCapacity;
+      /** \brief SORT_A or SORT_D, the order of sorted. */
+  char sortedOrder;
+      /** \brief indivChanges when sorted was built.
+       * \sa indivChanges */
+  unsigned long sortedAt;
       /** \brief name of this group, specified in inputs. */
   char *name;
 };
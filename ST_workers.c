@@ -0,0 +1,147 @@
+/**************************************************************************/
+/* ST_workers.c
+    Function definitions for running the iterations of a non-gridded
+    simulation in worker processes. See ST_workers.h for a description.
+
+    Worker w runs iterations w+1, w+1+nWorkers, w+1+2*nWorkers and so on.
+    It clears its accumulators before every iteration and writes them to a
+    pipe after the iteration. The parent reads the pipes in iteration order
+    and merges each iteration with stat_Merge_Accumulators, which produces
+    the same accumulators as running the iterations one after another.
+ */
+/**************************************************************************/
+
+/* fork(), pipe(), fdopen() and waitpid() are not part of C99. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "ST_workers.h"
+#include "ST_steppe.h"
+#include "ST_globals.h"
+#include "ST_stats.h"
+#include "ST_progressBar.h"
+#include "sw_src/filefuncs.h"
+#include "sw_src/myMemory.h"
+#include "sxw_funcs.h"
+
+extern SXW_t* SXW;
+extern Bool UseProgressBar;             // From ST_main.c
+extern int logged;                      // From ST_main.c
+
+/* Exit status of a worker that wrote to the logfile. */
+#define WORKER_LOGGED 2
+
+/*************** Local Function(s). Treat these as private. ***************/
+
+static void _run_worker(int worker, int nWorkers, FILE *out, void (*runIteration)(IntS iter));
+
+/*********************** Function Definitions *****************************/
+
+/* Run SuperGlobals.runModelIterations iterations in nWorkers processes and
+   merge their statistics into the accumulators of this process.
+
+   Call this after SXW_Init() while SOILWAT2 is ready for a first iteration.
+   runIteration must run a single iteration, including seeding the random
+   number generators and collecting statistics, starting from that state.
+   This process does not simulate anything itself, so afterwards its
+   SOILWAT2 memory is freed the same way as after a serial run. */
+void workers_RunIterations(int nWorkers, void (*runIteration)(IntS iter)){
+	int w, status, fds[2];
+	IntS iter;
+	pid_t *pids;
+	FILE **results;
+
+	if(nWorkers > SuperGlobals.runModelIterations){
+		nWorkers = SuperGlobals.runModelIterations;
+	}
+
+	pids = (pid_t*) Mem_Calloc(nWorkers, sizeof(pid_t), "workers_RunIterations: pids");
+	results = (FILE**) Mem_Calloc(nWorkers, sizeof(FILE*), "workers_RunIterations: results");
+
+	/* Anything still buffered would otherwise be written by every worker. */
+	fflush(NULL);
+
+	for(w = 0; w < nWorkers; ++w){
+		if(pipe(fds) != 0){
+			LogError(logfp, LOGFATAL, "workers_RunIterations: Could not create a pipe for worker %d.", w + 1);
+		}
+
+		pids[w] = fork();
+		if(pids[w] < 0){
+			LogError(logfp, LOGFATAL, "workers_RunIterations: Could not start worker %d.", w + 1);
+		} else if(pids[w] == 0){
+			close(fds[0]);
+			_run_worker(w, nWorkers, fdopen(fds[1], "wb"), runIteration);
+		}
+
+		close(fds[1]);
+		results[w] = fdopen(fds[0], "rb");
+		if(!results[w]){
+			LogError(logfp, LOGFATAL, "workers_RunIterations: Could not read from worker %d.", w + 1);
+		}
+	}
+
+	for(iter = 1; iter <= SuperGlobals.runModelIterations; ++iter){
+		w = (iter - 1) % nWorkers;
+		if(!stat_Merge_Accumulators(results[w])){
+			LogError(logfp, LOGFATAL, "Worker %d stopped before finishing iteration %d.", w + 1, iter);
+		}
+		if(UseProgressBar){
+			logProgress(iter, SuperGlobals.runModelYears, SIMULATION);
+		}
+	}
+
+	for(w = 0; w < nWorkers; ++w){
+		fclose(results[w]);
+		if(waitpid(pids[w], &status, 0) != pids[w] || !WIFEXITED(status)){
+			LogError(logfp, LOGFATAL, "Worker %d did not exit normally.", w + 1);
+		}
+		if(WEXITSTATUS(status) == WORKER_LOGGED){
+			logged = TRUE;
+		} else if(WEXITSTATUS(status) != 0){
+			LogError(logfp, LOGFATAL, "Worker %d failed.", w + 1);
+		}
+	}
+
+	Mem_Free(results);
+	Mem_Free(pids);
+}
+
+/* The body of a worker process. Never returns. */
+static void _run_worker(int worker, int nWorkers, FILE *out, void (*runIteration)(IntS iter)){
+	IntS iter;
+
+	if(!out){
+		LogError(logfp, LOGFATAL, "Worker %d could not open its pipe.", worker + 1);
+	}
+
+	/* Only the parent knows how far the whole run is. */
+	UseProgressBar = FALSE;
+
+	for(iter = worker + 1; iter <= SuperGlobals.runModelIterations; iter += nWorkers){
+		/* A serial run resets SOILWAT2 before every iteration but the first,
+		   so every iteration but the first starts from a reset SOILWAT2 here
+		   as well, even the first one of a worker. */
+		if(iter != 1){
+			SXW_Reset(SXW->f_watin);
+		}
+
+		stat_Clear_Accumulators();
+		runIteration(iter);
+
+		if(!stat_Write_Accumulators(out) || fflush(out) != 0){
+			LogError(logfp, LOGFATAL, "Worker %d could not send iteration %d.", worker + 1, iter);
+		}
+	}
+
+	fclose(out);
+	fflush(NULL);
+
+	/* _exit() skips the atexit() handlers of the parent, which reports on the
+	   logfile once for the whole run. */
+	_exit(logged ? WORKER_LOGGED : 0);
+}
@@ -0,0 +1,24 @@
+/******************************************************************/
+/* ST_workers.h
+    Defines all exported objects from ST_workers.c.
+
+    ST_workers.c runs the iterations of a non-gridded simulation in
+    several worker processes at once. It is only used with --streams,
+    where every iteration draws from its own random number streams (see
+    SimContext_SeedProcessRNGs), so an iteration gives the same result no
+    matter which process runs it.
+    The workers send the statistics of each iteration to the parent,
+    which merges them in iteration order.
+*/
+/******************************************************************/
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include "ST_defines.h"
+
+/******************** Exported Function(s) ************************/
+
+void workers_RunIterations(int nWorkers, void (*runIteration)(IntS iter));
+
+#endif
@@ -54,6 +54,7 @@
 #include "sxw.h"
 #include "sxw_funcs.h"
 #include "sxw_module.h"
+#include "ST_scratch.h"
 #include "sw_src/SW_Control.h"
 #include "sw_src/SW_Model.h"
 #include "sw_src/SW_VegProd.h"
@@ -77,7 +78,7 @@ extern SW_MODEL SW_Model;
 extern SW_VEGPROD SW_VegProd;
 extern SW_WEATHER SW_Weather;
 extern SW_MARKOV SW_Markov;
-//extern SW_SOILWAT SW_Soilwat;
+extern SW_SOILWAT SW_Soilwat;
 
 // defined in `SW_Output.c`:
 extern Bool prepare_IterationSummary;
@@ -94,6 +95,59 @@ transp_t* transp_window;
 pcg32_random_t resource_rng; //rng for swx_resource.c functions.
 SXW_resourceType* SXWResources;
 
+/**
+ * \brief A snapshot of the global \ref SOILWAT2 run state of one plot.
+ *
+ * SOILWAT2 keeps its state in process-wide globals, and in gridded mode every
+ * cell runs on that one instance. This is not a SOILWAT2 instance of its own:
+ * SOILWAT2 never runs on it. Each cell's SXW holds one snapshot, which
+ * \ref SXW_StoreSoilwatState takes when the cell is unloaded and
+ * \ref SXW_RestoreSite and \ref SXW_RestoreSoilwat copy back into the globals
+ * when the cell is loaded again. load_cell() in ST_grid.c only does this with
+ * --streams. Cells then carry their own soil water and weather history from
+ * year to year instead of starting from whatever the previous cell left
+ * behind, which changes gridded results (see CHANGES.md). Restoring the soils
+ * also saves recomputing them with set_soillayers().
+ *
+ * The structs are copied by value. Their pointer members are handled as
+ * follows:
+ * - SW_Site.lyr: the layers are copied into layers, and restoring copies
+ *   them back into the layers SOILWAT2 currently has allocated.
+ * - SW_Soilwat.hist.file_prefix: never taken from a copy. Restoring keeps
+ *   the live pointer, since gridded mode frees the prefix after every setup.
+ * - Any other memory SOILWAT2 allocates inside these structs, such as its
+ *   output accumulators and the weather generator's tables, stays shared by
+ *   all copies. It is set up with SOILWAT2 and every cell runs whole years
+ *   on it.
+ *
+ * A copy is therefore only valid for the SOILWAT2 instance it was taken
+ * from. generation identifies that instance.
+ *
+ * \sa SXW_StoreSoilwatState
+ *
+ * \ingroup SXW_private
+ */
+struct soilwat_state_st {
+	/** \brief The _soilwatGeneration this copy was taken from. 0 if no
+	 *         copy has been taken. */
+	unsigned long generation;
+	/** \brief The _soilwatGeneration in which this plot was last
+	 *         loaded into SOILWAT2. */
+	unsigned long liveGeneration;
+	/** \brief Copy of SW_Site. site.lyr is not used. */
+	SW_SITE site;
+	/** \brief Copy of every SW_Site.lyr, site.n_layers entries. */
+	SW_LAYER_INFO *layers;
+	/** \brief Number of entries allocated in layers. */
+	LyrIndex layerCapacity;
+	/** \brief Copy of SW_Soilwat. */
+	SW_SOILWAT soilwat;
+	/** \brief Copy of SW_Weather. */
+	SW_WEATHER weather;
+	/** \brief Copy of SW_Markov. */
+	SW_MARKOV markov;
+};
+
 /* These are only used here so they are static.  */
 // static char inbuf[FILENAME_MAX];   /* reusable input buffer */
 static char _swOutDefName[FILENAME_MAX];
@@ -101,6 +155,23 @@ static char *MyFileName;
 static char **_sxwfiles[SXW_NFILES];
 static char _debugout[256];
 static TimeInt _debugyrs[100], _debugyrs_cnt;
+/* Incremented every time SOILWAT2 is set up from scratch. */
+static unsigned long _soilwatGeneration = 1;
+/* SW_Soilwat, SW_Weather and SW_Markov as they were right after SOILWAT2 was
+   set up, for plots without a valid copy of their own. Taken the first time a
+   plot is loaded. */
+static SW_SOILWAT _initialSoilwat;
+static SW_WEATHER _initialWeather;
+static SW_MARKOV _initialMarkov;
+static unsigned long _initialSoilwatGeneration = 0;
+/* SOILWAT2 as SXW_Reinit() read it from disk, before SW_CTL_init_run(), so
+   that SXW_Reset() can put it back instead of reading every input file
+   again. _setupFile is the input file it was read from, NULL if there is no
+   copy. */
+static struct soilwat_state_st _setupState;
+static SW_MODEL _setupModel;
+static SW_VEGPROD _setupVegProd;
+static char *_setupFile = NULL;
 
 /*************** Local Function Declarations ***************/
 /***********************************************************/
@@ -112,6 +183,8 @@ static void _read_phen(void);
 static void _read_prod(void);
 static void _read_watin(void);
 static void _make_arrays(void);
+static void _make_tables(void);
+static void _make_roots_tables(void);
 static void _make_roots_arrays(void);
 static void _make_phen_arrays(void);
 static void _make_prod_arrays(void);
@@ -122,6 +195,9 @@ void debugCleanUp(void);
 static void _make_swc_array(void);
 static void SXW_SW_Setup_Echo(void);
 static void SXW_Reinit(char* SOILWAT_file);
+static void _save_initial_soilwat(void);
+static void _save_setup_state(char* SOILWAT_file);
+static Bool _restore_setup_state(char* SOILWAT_file);
 
 void save_sxw_memory( RealD * grid_roots_max, RealD* grid_rootsXphen, RealD* grid_roots_active, RealD* grid_roots_active_rel, RealD* grid_roots_active_sum, RealD* grid_phen, RealD* grid_prod_bmass, RealD* grid_prod_pctlive );
 SXW_t* getSXW(void);
@@ -215,6 +291,61 @@ void SXW_Init( Bool init_SW, char *f_roots ) {
 #endif
 }
 
+/**
+ * \brief Initialize the SXW variables as a copy of another plot's, without
+ *        reading any input files.
+ *
+ * This gives the same result as \ref SXW_Init with init_SW FALSE and the
+ * same f_roots as the template was initialized with, as long as \ref RGroup
+ * is the same and SOILWAT2 holds the soils the template was initialized
+ * with. Gridded mode uses this so the inputs are only read for the first
+ * cell.
+ *
+ * The root, phenology and production tables are not copied but shared with
+ * the template, since nothing changes them after they are read. Only the
+ * arrays that change during a run are allocated for this plot.
+ *
+ * \param src is the SXW of the plot to copy.
+ * \param srcResources is the SXWResources of the plot to copy.
+ *
+ * \ingroup SXW
+ */
+void SXW_InitFrom(const SXW_t *src, const SXW_resourceType *srcResources) {
+	RandSeed(SuperGlobals.randseed, &resource_rng);
+
+	_allocate_memory();
+
+	_sxwfiles[0] = &SXW->f_roots;
+	_sxwfiles[1] = &SXW->f_phen;
+	_sxwfiles[2] = &SXW->f_prod;
+	_sxwfiles[3] = &SXW->f_watin;
+
+	SXW->f_files = src->f_files;  /* aliased */
+	SXW->f_roots = Str_Dup(src->f_roots);
+	SXW->f_phen = Str_Dup(src->f_phen);
+	SXW->f_prod = Str_Dup(src->f_prod);
+	SXW->f_watin = Str_Dup(src->f_watin);
+	SXW->debugfile = NULL;
+
+	SXW->NGrps = src->NGrps;
+	SXW->NPds = src->NPds;
+	SXW->NTrLyrs = src->NTrLyrs;
+	SXW->NSoLyrs = src->NSoLyrs;
+
+	SXWResources->_roots_max = srcResources->_roots_max;
+	SXWResources->_rootsXphen = srcResources->_rootsXphen;
+	SXWResources->_phen = srcResources->_phen;
+	SXWResources->_prod_litter = srcResources->_prod_litter;
+	SXWResources->_prod_bmass = srcResources->_prod_bmass;
+	SXWResources->_prod_pctlive = srcResources->_prod_pctlive;
+	SXWResources->_tableRefs = srcResources->_tableRefs;
+	(*SXWResources->_tableRefs)++;
+
+	_make_roots_arrays();
+	_make_transp_arrays();
+	_make_swc_array();
+}
+
 /**
  * @brief This function initializes and allocates SOILWAT2 structures,
  *		  and reads SOILWAT2 inputs.
@@ -231,12 +362,18 @@ static void SXW_Reinit(char* SOILWAT_file) {
 	// read user inputs
 	SW_CTL_read_inputs_from_disk();
 
+	// keep the inputs, so that SXW_Reset() does not need to read them again
+	_save_setup_state(SOILWAT_file);
+
 	// initialize simulation run (based on user inputs)
 	SW_CTL_init_run();
 
 	// initialize output: transfer between STEPPE and SOILWAT2
 	SW_OUT_set_SXWrequests();
     free(temp);
+
+	// every stored SOILWAT2 state now points to freed memory
+	_soilwatGeneration++;
 }
 
 
@@ -251,13 +388,228 @@ static void SXW_Reinit(char* SOILWAT_file) {
  * over from one STEPWAT2 iteration to the next. They are only de-allocated
  * at the end of an entire STEPWAT2 run (see `ST_main.c/main()`).
  * 
+ * If SOILWAT2 was last set up from the same file, the copy of the inputs
+ * read by that setup is put back instead, which reads no files. The run is
+ * then initialized with SW_CTL_init_run() as after reading the inputs, which
+ * also resets the state SOILWAT2's modules keep between years, e.g. that of
+ * the soil temperature and of SW_VegEstab. State that only the construction
+ * of SOILWAT2's modules resets is not covered. Compiling with
+ * SXW_REREAD_INPUTS always reads the inputs again, so the two can be
+ * compared (see `make bint_compare_reset`).
+ * 
  * \ingroup SXW
  */
 void SXW_Reset(char* SOILWAT_file) {
+	if(_restore_setup_state(SOILWAT_file)) {
+		// initialize simulation run (based on the restored inputs)
+		SW_CTL_init_run();
+
+		// the plots' stored SOILWAT2 states belong to the previous iteration
+		_soilwatGeneration++;
+		return;
+	}
+
 	SW_CTL_clear_model(FALSE); // don't reset output arrays
 	SXW_Reinit(SOILWAT_file);
 }
 
+/* Copy the inputs SOILWAT2 just read from SOILWAT_file, before the run is
+   initialized. This is what a SOILWAT2 run changes from one iteration to
+   the next: the same structs a plot carries in its soilwat_state_st, plus
+   SW_Model and SW_VegProd. */
+static void _save_setup_state(char* SOILWAT_file) {
+	LyrIndex i;
+
+	if(SW_Site.n_layers > _setupState.layerCapacity) {
+		if(_setupState.layers) {
+			Mem_Free(_setupState.layers);
+		}
+		_setupState.layers = (SW_LAYER_INFO*) Mem_Calloc(SW_Site.n_layers, sizeof(SW_LAYER_INFO),
+		                                                 "_save_setup_state: layers");
+		_setupState.layerCapacity = SW_Site.n_layers;
+	}
+
+	_setupState.site = SW_Site;
+	for(i = 0; i < SW_Site.n_layers; i++) {
+		_setupState.layers[i] = *SW_Site.lyr[i];
+	}
+	_setupState.soilwat = SW_Soilwat;
+	_setupState.weather = SW_Weather;
+	_setupState.markov = SW_Markov;
+	_setupModel = SW_Model;
+	_setupVegProd = SW_VegProd;
+
+	if(!_setupFile || strcmp(_setupFile, SOILWAT_file) != 0) {
+		if(_setupFile) {
+			Mem_Free(_setupFile);
+		}
+		_setupFile = Str_Dup(SOILWAT_file);
+	}
+}
+
+/* Put back the state _save_setup_state() copied. Returns FALSE if that is not
+   possible and SOILWAT2 has to be set up from disk:
+   - there is no copy of a setup from SOILWAT_file,
+   - the soils have a different number of layers since,
+   - SOILWAT2 writes output files per iteration, which only a new setup
+     opens and closes correctly, or
+   - the model was compiled with SXW_REREAD_INPUTS.
+   SW_Site.lyr and SW_Soilwat.hist.file_prefix keep their current memory;
+   gridded mode frees the file prefix after every setup. */
+static Bool _restore_setup_state(char* SOILWAT_file) {
+	SW_LAYER_INFO **lyr = SW_Site.lyr;
+	char *file_prefix = SW_Soilwat.hist.file_prefix;
+	LyrIndex i;
+
+#ifdef SXW_REREAD_INPUTS
+	return FALSE;
+#endif
+	if(storeAllIterations || !_setupFile || strcmp(_setupFile, SOILWAT_file) != 0
+	   || _setupState.site.n_layers != SW_Site.n_layers) {
+		return FALSE;
+	}
+
+	SW_Site = _setupState.site;
+	SW_Site.lyr = lyr;
+	for(i = 0; i < SW_Site.n_layers; i++) {
+		*SW_Site.lyr[i] = _setupState.layers[i];
+	}
+	SW_Soilwat = _setupState.soilwat;
+	SW_Soilwat.hist.file_prefix = file_prefix;
+	SW_Weather = _setupState.weather;
+	SW_Markov = _setupState.markov;
+	SW_Model = _setupModel;
+	SW_VegProd = _setupVegProd;
+	return TRUE;
+}
+
+/**
+ * \brief Snapshot the current SW_Site, SW_Soilwat, SW_Weather and SW_Markov
+ *        into the loaded SXW.
+ *
+ * Nothing is saved unless the loaded plot was put into SOILWAT2 with
+ * \ref SXW_RestoreSoilwat since SOILWAT2 was last set up. This keeps a
+ * freshly reset SOILWAT2, which does not carry the plot's soils yet, from
+ * overwriting the plot's state.
+ *
+ * \sa load_cell() in ST_grid.c where this function is called before switching
+ *     cells.
+ *
+ * \ingroup SXW
+ */
+void SXW_StoreSoilwatState(void) {
+	struct soilwat_state_st *state;
+	LyrIndex i;
+
+	if(!SXW || !SXW->soilwatState) {
+		return;
+	}
+	state = SXW->soilwatState;
+	if(state->liveGeneration != _soilwatGeneration) {
+		return;
+	}
+
+	if(SW_Site.n_layers > state->layerCapacity) {
+		if(state->layers) {
+			Mem_Free(state->layers);
+		}
+		state->layers = (SW_LAYER_INFO*) Mem_Calloc(SW_Site.n_layers, sizeof(SW_LAYER_INFO),
+		                                            "SXW_StoreSoilwatState: layers");
+		state->layerCapacity = SW_Site.n_layers;
+	}
+
+	state->site = SW_Site;
+	for(i = 0; i < SW_Site.n_layers; i++) {
+		state->layers[i] = *SW_Site.lyr[i];
+	}
+	state->soilwat = SW_Soilwat;
+	state->weather = SW_Weather;
+	state->markov = SW_Markov;
+	state->generation = _soilwatGeneration;
+}
+
+/**
+ * \brief Copy the loaded SXW's snapshot of SW_Site back into SOILWAT2.
+ *
+ * The layers are copied into the layers SOILWAT2 has already allocated, so
+ * this only works if SOILWAT2 currently holds the same number of layers.
+ *
+ * \return TRUE if SW_Site was restored. FALSE if the caller has to set up
+ *         the soil layers with set_soillayers().
+ *
+ * \ingroup SXW
+ */
+Bool SXW_RestoreSite(void) {
+	struct soilwat_state_st *state;
+	SW_LAYER_INFO **lyr = SW_Site.lyr;
+	LyrIndex i;
+
+	if(!SXW || !SXW->soilwatState) {
+		return FALSE;
+	}
+	state = SXW->soilwatState;
+	_save_initial_soilwat();
+
+	if(state->generation != _soilwatGeneration || state->site.n_layers != SW_Site.n_layers) {
+		return FALSE;
+	}
+
+	SW_Site = state->site;
+	SW_Site.lyr = lyr;
+	for(i = 0; i < SW_Site.n_layers; i++) {
+		*SW_Site.lyr[i] = state->layers[i];
+	}
+	return TRUE;
+}
+
+/**
+ * \brief Copy the loaded SXW's snapshot of SW_Soilwat, SW_Weather and
+ *        SW_Markov back into SOILWAT2 and mark the plot as the one SOILWAT2 is
+ *        running.
+ *
+ * Call this after the soils of the plot are in place, either through
+ * \ref SXW_RestoreSite or set_soillayers(). If no copy was taken since
+ * SOILWAT2 was last set up the plot starts from the state that SOILWAT2 was
+ * set up with.
+ *
+ * \ingroup SXW
+ */
+void SXW_RestoreSoilwat(void) {
+	struct soilwat_state_st *state;
+	char *file_prefix;
+
+	if(!SXW || !SXW->soilwatState) {
+		return;
+	}
+	state = SXW->soilwatState;
+	_save_initial_soilwat();
+
+	file_prefix = SW_Soilwat.hist.file_prefix;
+	if(state->generation == _soilwatGeneration) {
+		SW_Soilwat = state->soilwat;
+		SW_Weather = state->weather;
+		SW_Markov = state->markov;
+	} else {
+		SW_Soilwat = _initialSoilwat;
+		SW_Weather = _initialWeather;
+		SW_Markov = _initialMarkov;
+	}
+	SW_Soilwat.hist.file_prefix = file_prefix;
+	state->liveGeneration = _soilwatGeneration;
+}
+
+/* Take the copies of SW_Soilwat, SW_Weather and SW_Markov that plots without
+   their own copy start from. This has to happen before the first plot is
+   loaded after SOILWAT2 was set up, because loading a plot modifies them. */
+static void _save_initial_soilwat(void) {
+	if(_initialSoilwatGeneration != _soilwatGeneration) {
+		_initialSoilwat = SW_Soilwat;
+		_initialWeather = SW_Weather;
+		_initialMarkov = SW_Markov;
+		_initialSoilwatGeneration = _soilwatGeneration;
+	}
+}
+
 /**
  * \brief Resets the SOILWAT2 transpiration tables. This should be called 
  *        every iteration.
@@ -285,7 +637,7 @@ void SXW_Run_SOILWAT(void) {
     SppIndex sp;
     RealF *sizes;
 
-        sizes = (RealF *)Mem_Calloc(SuperGlobals.max_rgroups, sizeof(RealF), "SXW_Run_SOILWAT");
+        sizes = (RealF *)scratch_Alloc(SuperGlobals.max_rgroups, sizeof(RealF), "SXW_Run_SOILWAT");
 
     /* Compute current STEPPE biomass which represents last year's biomass and biomass due to establishment this year (for perennials) and biomass due to establishment this year (for annuals) */
     ForEachGroup(g) {
@@ -318,8 +670,6 @@ void SXW_Run_SOILWAT(void) {
 
     /* Set annual precipitation and annual temperature */
     _sxw_set_environs();
-
-    Mem_Free(sizes);
 }
 
 void SXW_SW_Setup_Echo(void) {
@@ -458,6 +808,8 @@ static void _allocate_memory(void){
 	SXWResources = (SXW_resourceType*) Mem_Calloc(1, sizeof(SXW_resourceType), "_allocate_memory: SXWResources");
 
 	SXWResources->_resource_cur = (RealF *)Mem_Calloc(SuperGlobals.max_rgroups, sizeof(RealF), "_allocate_memory: _resource_cur");
+
+	SXW->soilwatState = (struct soilwat_state_st*) Mem_Calloc(1, sizeof(struct soilwat_state_st), "_allocate_memory: soilwatState");
 }
 
 /* Returns a pointer to the local SXW variable. */
@@ -763,23 +1115,43 @@ static void _make_arrays(void) {
 /* central point to make all dynamically allocated arrays
  * now that the dimensions are known.
  */
+	_make_tables();
 	_make_roots_arrays();
-	_make_phen_arrays();
-	_make_prod_arrays();
 	_make_transp_arrays();
 	_make_swc_array();
 }
 
-static void _make_roots_arrays(void) {
+static void _make_tables(void) {
+/*======================================================*/
+/* the tables that are read from input and never change,
+ * which SXW_InitFrom() shares between plots.
+ */
+	SXWResources->_tableRefs = (int *) Mem_Calloc(1, sizeof(int), "_make_tables()");
+	*SXWResources->_tableRefs = 1;
+
+	_make_roots_tables();
+	_make_phen_arrays();
+	_make_prod_arrays();
+}
+
+static void _make_roots_tables(void) {
 /*======================================================*/
   int size;
-  char *fstr = "_make_roots_array()";
+  char *fstr = "_make_roots_tables()";
 
   size  = SXW->NGrps * SXW->NTrLyrs;
   SXWResources->_roots_max     = (RealD *) Mem_Calloc(size, sizeof(RealD), fstr);
 
   size = SXW->NGrps * SXW->NPds * SXW->NTrLyrs;
-  SXWResources->_rootsXphen       = (RealD *) Mem_Calloc(size, sizeof(RealD), fstr);
+  SXWResources->_rootsXphen    = (RealD *) Mem_Calloc(size, sizeof(RealD), fstr);
+}
+
+static void _make_roots_arrays(void) {
+/*======================================================*/
+  int size;
+  char *fstr = "_make_roots_array()";
+
+  size = SXW->NGrps * SXW->NPds * SXW->NTrLyrs;
   SXWResources->_roots_active     = (RealD *) Mem_Calloc(size, sizeof(RealD), fstr);
   SXWResources->_roots_active_rel = (RealD *) Mem_Calloc(size, sizeof(RealD), fstr);
 
@@ -1202,19 +1574,23 @@ void free_all_sxw_memory( void ) {
 	Mem_Free(transp_window);
 
     /* Free SXWResources */
-	Mem_Free(SXWResources->_phen);
-	Mem_Free(SXWResources->_prod_bmass);
-	Mem_Free(SXWResources->_prod_pctlive);
 	Mem_Free(SXWResources->_resource_cur);
 	Mem_Free(SXWResources->_roots_active);
 	Mem_Free(SXWResources->_roots_active_rel);
 	Mem_Free(SXWResources->_roots_active_sum);
-	Mem_Free(SXWResources->_roots_max);
-	Mem_Free(SXWResources->_rootsXphen);
-    for(k = 0; k < SXW->NGrps; ++k){
-        Mem_Free(SXWResources->_prod_litter[k]);
-    }
-    Mem_Free(SXWResources->_prod_litter);
+	/* The tables may be shared with other plots, see SXW_InitFrom(). */
+	if(--(*SXWResources->_tableRefs) == 0){
+		Mem_Free(SXWResources->_phen);
+		Mem_Free(SXWResources->_prod_bmass);
+		Mem_Free(SXWResources->_prod_pctlive);
+		Mem_Free(SXWResources->_roots_max);
+		Mem_Free(SXWResources->_rootsXphen);
+		for(k = 0; k < SXW->NGrps; ++k){
+			Mem_Free(SXWResources->_prod_litter[k]);
+		}
+		Mem_Free(SXWResources->_prod_litter);
+		Mem_Free(SXWResources->_tableRefs);
+	}
 	Mem_Free(SXWResources);
 
 	/* Free SXW */
@@ -1227,5 +1603,21 @@ void free_all_sxw_memory( void ) {
 		Mem_Free(SXW->transpVeg[k]);
 	}
 	Mem_Free(SXW->swc);
+	if(SXW->soilwatState->layers){
+		Mem_Free(SXW->soilwatState->layers);
+	}
+	Mem_Free(SXW->soilwatState);
 	Mem_Free(SXW);
+
+	/* Free the copy of the SOILWAT2 setup. Gridded mode calls this once per
+	   cell, so the copy is only freed the first time. */
+	if(_setupState.layers){
+		Mem_Free(_setupState.layers);
+		_setupState.layers = NULL;
+		_setupState.layerCapacity = 0;
+	}
+	if(_setupFile){
+		Mem_Free(_setupFile);
+		_setupFile = NULL;
+	}
 }
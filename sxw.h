@@ -67,6 +67,9 @@ struct stepwat_st {
 
   // ------ DEBUG stuff:
   char *debugfile; /* added in ST_Main(), read to get debug instructions */
+
+  // ------ Snapshot of the SOILWAT2 globals for this plot, private to sxw.c:
+  struct soilwat_state_st *soilwatState;
 } typedef SXW_t;
 
 /** 
@@ -153,6 +156,11 @@ struct temp_SXW_st{
   RealD* _prod_bmass;
   RealD* _prod_pctlive;
 
+  /* _roots_max, _rootsXphen, _phen and the _prod tables do not change after
+   * they are read, so plots set up with SXW_InitFrom() share them. This
+   * counts the plots sharing them; the last one frees them. */
+  int *_tableRefs;
+
 } typedef SXW_resourceType;
 
 #define ForEachTrPeriod(i) for((i)=0; (i)< SXW->NPds; (i)++)
@@ -20,7 +20,11 @@ RealF SXW_GetTranspiration( GrpIndex rg);
 int get_SW2_veg_index(int veg_prod_type);
 
 void SXW_Init( Bool init_SW, char *f_roots );
+void SXW_InitFrom(const SXW_t *src, const SXW_resourceType *srcResources);
 void SXW_Reset(char* SOILWAT_file);
+void SXW_StoreSoilwatState(void);
+Bool SXW_RestoreSite(void);
+void SXW_RestoreSoilwat(void);
 void SXW_Run_SOILWAT (void);
 void SXW_InitPlot (void);
 void SXW_PrintDebug(Bool cleanup) ;
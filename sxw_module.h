@@ -31,7 +31,7 @@
 /* These functions are found in sxw_resource.c */
 void _sxw_root_phen(void);
 void _sxw_update_resource(void);
-void _sxw_update_root_tables( RealF sizes[] );
+void _sxw_update_root_tables( RealF sizes[], RealD transp_by_group[] );
 
 
 /* These functions are found in sxw_soilwat.c */
@@ -31,6 +31,7 @@
 #include "sxw.h"
 #include "sxw_module.h"
 #include "sxw_vars.h"
+#include "ST_scratch.h"
 #include "sw_src/SW_Control.h"
 #include "sw_src/SW_Site.h"
 #include "sw_src/SW_SoilWater.h"
@@ -61,7 +62,7 @@ extern
 /*************** Local Function Declarations ***************/
 /***********************************************************/
 
-static void _transp_contribution_by_group(RealF use_by_group[]);
+static void _transp_contribution_by_group(RealF use_by_group[], const RealD transp_by_group[]);
 
 /***********************************************************/
 /****************** Begin Function Code ********************/
@@ -102,9 +103,11 @@ void _sxw_update_resource(void) {
  * scale resources available (cm) to resources in terms of grams of biomass */
 
   RealF *sizes;
+  RealD *transp_by_group;
   GrpIndex g;
 
-  sizes = (RealF *)Mem_Calloc(SuperGlobals.max_rgroups, sizeof(RealF), "_sxw_update_resource");
+  sizes = (RealF *)scratch_Alloc(SuperGlobals.max_rgroups, sizeof(RealF), "_sxw_update_resource");
+  transp_by_group = (RealD *)scratch_Alloc(SuperGlobals.max_rgroups, sizeof(RealD), "_sxw_update_resource");
 
 	ForEachGroup(g)
 	{
@@ -116,10 +119,10 @@ void _sxw_update_resource(void) {
 	}
 
     /* Update the active relative roots based on current biomass values */
-	_sxw_update_root_tables(sizes);
+	_sxw_update_root_tables(sizes, transp_by_group);
 
 	/* Assign transpiration (resource availability) to each STEPPE functional group */
-	_transp_contribution_by_group(SXWResources->_resource_cur);
+	_transp_contribution_by_group(SXWResources->_resource_cur, transp_by_group);
 
         /* Scale transpiration resources by a constant, bvt, to convert resources
          * (cm) to biomass that can be supported by those resources (g/cm) */
@@ -129,37 +132,55 @@ void _sxw_update_resource(void) {
                                 //_resource_cur[g], SXWResources->_resource_cur[g] * RGroup[g]->_bvt);
 		SXWResources->_resource_cur[g] = SXWResources->_resource_cur[g] * RGroup[g]->_bvt;
 	}
-
-    Mem_Free(sizes);
 }
 
-void _sxw_update_root_tables( RealF sizes[] ) {
+void _sxw_update_root_tables( RealF sizes[], RealD transp_by_group[] ) {
 /*======================================================*/
 /* Updates the active relative roots array based on sizes, which contains the groups'
  * actual biomass in grams. This array in utilized in partitioning of transpiration
- * (resources) to each STEPPE functional group. */
+ * (resources) to each STEPPE functional group.
+ *
+ * The last pass also weights SXW->transpTotal by the relative active roots and
+ * sums it over layers and months into transp_by_group, which is what
+ * _transp_contribution_by_group() assigns to each group.
+ *
+ * All of the tables are indexed group (or veg type), layer, month with the
+ * month varying fastest, and so is SXW->transpTotal. The first nLyrs layers of
+ * a group are therefore one contiguous run of nLyrs * NPds values with the same
+ * offsets in every table, which is what the loops below walk. */
 
 	GrpIndex g;
-	LyrIndex l, nLyrs;
-	TimeInt p;
-	RealD x, sum_all_veg_types;
-	int t;
+	int i, n, t,
+	    nCells = SXW->NTrLyrs * SXW->NPds;  /* values per group or veg type */
+	RealD size, use,
+	      *active, *rel, *vegSum, *total;
+	const RealD *rootsXphen, *transp = SXW->transpTotal;
 
 	/* Set some things to zero where 4 refers to Tree, Shrub, Grass, Forb */
-	Mem_Set(SXWResources->_roots_active_sum, 0, NVEGTYPES * SXW->NPds * SXW->NTrLyrs * sizeof(RealD));
+	Mem_Set(SXWResources->_roots_active_sum, 0, NVEGTYPES * nCells * sizeof(RealD));
 
         /* Calculate the active roots in each month and soil layer for each STEPPE
          * functional group based on the functional group biomass this year */
 	ForEachGroup(g)
 	{
-		nLyrs = getNTranspLayers(RGroup[g]->veg_prod_type);
-		for (l = 0; l < nLyrs; l++) {
-			ForEachTrPeriod(p)
-			{
-				x = SXWResources->_rootsXphen[Iglp(g, l, p)] * sizes[g];
-				SXWResources->_roots_active[Iglp(g, l, p)] = x;
-				SXWResources->_roots_active_sum[Itlp(RGroup[g]->veg_prod_type, l, p)] += x;
-			}
+		n = getNTranspLayers(RGroup[g]->veg_prod_type) * SXW->NPds;
+		size = sizes[g];
+		rootsXphen = SXWResources->_rootsXphen + Iglp(g, 0, 0);
+		active = SXWResources->_roots_active + Iglp(g, 0, 0);
+		vegSum = SXWResources->_roots_active_sum + Itlp(RGroup[g]->veg_prod_type, 0, 0);
+		for (i = 0; i < n; i++) {
+			active[i] = rootsXphen[i] * size;
+			vegSum[i] += active[i];
+		}
+	}
+
+	/* The active roots of all veg types in each layer and month, summed in
+	   the same order as the veg types. */
+	total = (RealD *) scratch_Alloc(nCells, sizeof(RealD), "_sxw_update_root_tables");
+	ForEachVegType(t) {
+		vegSum = SXWResources->_roots_active_sum + Itlp(t, 0, 0);
+		for (i = 0; i < nCells; i++) {
+			total[i] += vegSum[i];
 		}
 	}
 
@@ -167,31 +188,30 @@ void _sxw_update_root_tables( RealF sizes[] ) {
          * STEPPE group's roots in a given layer in a given month */
   /* Details: for each soil layer `l` and each month (trperiod) `p`, the sum
      of `_roots_active_rel[Iglp(g, l, p)]` across rgroups `g` must be 1;
-     see its use by function _transp_contribution_by_group() */
+     only if they sum to 1, can they can be used as proper weights
+     for `transp[Ilp(l, p)]` to be split up among rgroups */
 	ForEachGroup(g)
 	{
-		nLyrs = getNTranspLayers(RGroup[g]->veg_prod_type);
-		
-		for (l = 0; l < nLyrs; l++) {
-			ForEachTrPeriod(p)
-			{
-        sum_all_veg_types = 0;
-        ForEachVegType(t) {
-          sum_all_veg_types += SXWResources->_roots_active_sum[Itlp(t, l, p)];
-        }
+		n = getNTranspLayers(RGroup[g]->veg_prod_type) * SXW->NPds;
+		active = SXWResources->_roots_active + Iglp(g, 0, 0);
+		rel = SXWResources->_roots_active_rel + Iglp(g, 0, 0);
+		for (i = 0; i < n; i++) {
+			rel[i] = ZRO(total[i]) ? 0. : active[i] / total[i];
+		}
 
-				SXWResources->_roots_active_rel[Iglp(g, l, p)] = ZRO(sum_all_veg_types) ? 0. 
-                                         : SXWResources->_roots_active[Iglp(g, l, p)] / sum_all_veg_types;
-			}
+		use = 0.;
+		for (i = 0; i < n; i++) {
+			use += rel[i] * transp[i];
 		}
+		transp_by_group[g] = use;
 	}
-
 }
 
-static void _transp_contribution_by_group(RealF use_by_group[]) {
+static void _transp_contribution_by_group(RealF use_by_group[], const RealD transp_by_group[]) {
     /*======================================================*/
     /* use_by_group is the amount of transpiration (cm) assigned to each STEPPE
-     * functional group. Must call _update_root_tables() before this.
+     * functional group. Must call _update_root_tables() before this, which
+     * computes transp_by_group.
      * Compute each group's amount of transpiration from SOILWAT2
      * based on its biomass, root distribution, and phenological
      * activity. This represents "normal" resources or transpiration each year.
@@ -200,9 +220,8 @@ static void _transp_contribution_by_group(RealF use_by_group[]) {
 
     GrpIndex g;
     TimeInt p;
-    int nLyrs, t;
-    LyrIndex l;
-    RealD *transp, proportion_total_resources, average_proportion;
+    int t;
+    RealD proportion_total_resources, average_proportion;
     RealF sumUsedByGroup = 0., sumTranspTotal = 0., TranspRemaining = 0.;
     RealF transp_ratio, transp_ratio_sd;
     transp_window->added_transp = 0;
@@ -221,21 +240,9 @@ static void _transp_contribution_by_group(RealF use_by_group[]) {
 
     ForEachGroup(g) //Steppe functional group
     {
-        use_by_group[g] = 0.;
-        transp = SXW->transpTotal;
-
-        //Loops through each month and calculates amount of transpiration for each STEPPE functional group
-        //according to whether that group has active living roots in each soil layer for each month
-        /* Details: for each soil layer `l` and each month (trperiod) `p`, the
-           sum of `_roots_active_rel[Iglp(g, l, p)]` across rgroups `g` must
-           be 1; only if they sum to 1, can they can be used as proper weights
-           for `transp[Ilp(l, p)]` to be split up among rgroups */
-        ForEachTrPeriod(p) {
-            nLyrs = getNTranspLayers(RGroup[g]->veg_prod_type);
-            for (l = 0; l < nLyrs; l++) {
-                use_by_group[g] += (RealF) (SXWResources->_roots_active_rel[Iglp(g, l, p)] * transp[Ilp(l, p)]);
-            }
-        }
+        //Amount of transpiration for each STEPPE functional group according to whether
+        //that group has active living roots in each soil layer for each month
+        use_by_group[g] = (RealF) transp_by_group[g];
 
         sumUsedByGroup += use_by_group[g];
         //printf(" sumUsedByGroup in transp=%f \n",sumUsedByGroup);
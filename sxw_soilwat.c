@@ -91,6 +91,14 @@ void _sxw_sw_setup (RealF sizes[]) {
 
 void _sxw_sw_run(void) {
 /*======================================================*/
+/* Run SOILWAT2 for the current year. SOILWAT2 hands back the values
+ * STEPPE needs (monthly transpiration and SWCbulk by layer, monthly
+ * PPT and temperature, annual AET) through the output requests that
+ * SW_OUT_set_SXWrequests() registers, so they are aggregated by its
+ * regular output code at the end of each day. Skipping that machinery
+ * when -o and -i are not given would mean summing the daily values
+ * inside SW_CTL_run_current_year(), which belongs to SOILWAT2 and not
+ * to this module. */
 	SW_Model.year = SW_Model.startyr + Globals->currYear-1;
 	SW_CTL_run_current_year();
 }
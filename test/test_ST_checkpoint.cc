@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "test_ST_checkpoint.h"
+
+namespace {
+
+const int nYears = 2;
+const int maxAge = 4;
+const int viableYears = 3;
+const int windowSize = 3;
+
+/* A non-gridded plot with one group and one species that has individuals,
+   kills, seed production, group and species biomass accumulators and a
+   transpiration window. */
+class CheckpointTest : public ::testing::Test {
+protected:
+    char groupName[5] = "grp1";
+    char speciesName[5] = "spp1";
+    char fileName[64];
+    transp_t window;
+
+    void SetUp() override {
+        strcpy(fileName, "/tmp/stepwat_test_checkpointXXXXXX");
+        int fd = mkstemp(fileName);
+        ASSERT_NE(fd, -1);
+        close(fd);
+
+        SuperGlobals.runModelYears = nYears;
+        SuperGlobals.runModelIterations = 5;
+        SuperGlobals.max_spp_per_grp = 1;
+        SuperGlobals.randseed = -42;
+        UseGrid = (Bool) TRUE;
+        BmassFlags = BmassFlagsType();
+        BmassFlags.grpb = (Bool) TRUE;
+        BmassFlags.sppb = (Bool) TRUE;
+        MortFlags = MortFlagsType();
+
+        Globals = (ModelType *)Mem_Calloc(1, sizeof(ModelType), nullptr);
+        Globals->grpCount = 1;
+        Globals->sppCount = 1;
+        Env = (EnvType *)Mem_Calloc(1, sizeof(EnvType), nullptr);
+        Plot = (PlotType *)Mem_Calloc(1, sizeof(PlotType), nullptr);
+        Succulent = (SucculentType *)Mem_Calloc(1, sizeof(SucculentType), nullptr);
+
+        RGroup = (GroupType **)Mem_Calloc(1, sizeof(GroupType *), nullptr);
+        RGroup[0] = (GroupType *)Mem_Calloc(1, sizeof(GroupType), nullptr);
+        RGroup[0]->name = groupName;
+        RGroup[0]->max_age = maxAge;
+        RGroup[0]->kills = (IntUS *)Mem_Calloc(maxAge, sizeof(IntUS), nullptr);
+        RGroup[0]->est_spp = (SppIndex *)Mem_Calloc(1, sizeof(SppIndex), nullptr);
+        RGroup[0]->species = (SppIndex *)Mem_Calloc(1, sizeof(SppIndex), nullptr);
+
+        Species = (SpeciesType **)Mem_Calloc(1, sizeof(SpeciesType *), nullptr);
+        Species[0] = (SpeciesType *)Mem_Calloc(1, sizeof(SpeciesType), nullptr);
+        Species[0]->name = speciesName;
+        Species[0]->max_age = maxAge;
+        Species[0]->viable_yrs = viableYears;
+        Species[0]->kills = (IntUS *)Mem_Calloc(maxAge, sizeof(IntUS), nullptr);
+        Species[0]->seedprod = (IntUS *)Mem_Calloc(viableYears, sizeof(IntUS), nullptr);
+
+        window = transp_t();
+        window.size = windowSize;
+        window.ratios = (RealF *)Mem_Calloc(windowSize, sizeof(RealF), nullptr);
+        window.transp = (RealF *)Mem_Calloc(windowSize, sizeof(RealF), nullptr);
+        window.SoS_array = (RealF *)Mem_Calloc(windowSize, sizeof(RealF), nullptr);
+        copy_sxw_variables(NULL, NULL, &window);
+
+        stat_Copy_Accumulators(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, (Bool) TRUE);
+        stat_Clear_Accumulators();
+    }
+
+    void TearDown() override {
+        stat_free_mem();
+        copy_sxw_variables(NULL, NULL, NULL);
+        Mem_Free(window.ratios);
+        Mem_Free(window.transp);
+        Mem_Free(window.SoS_array);
+        Indiv_FreeStorage(Species[0]);
+        Mem_Free(Species[0]->seedprod);
+        Mem_Free(Species[0]->kills);
+        Mem_Free(Species[0]);
+        Mem_Free(Species);
+        Mem_Free(RGroup[0]->species);
+        Mem_Free(RGroup[0]->est_spp);
+        Mem_Free(RGroup[0]->kills);
+        Mem_Free(RGroup[0]);
+        Mem_Free(RGroup);
+        Mem_Free(Succulent);
+        Mem_Free(Plot);
+        Mem_Free(Env);
+        Mem_Free(Globals);
+        UseGrid = (Bool) FALSE;
+        SuperGlobals.randseed = 0;
+        unlink(fileName);
+    }
+
+    /* Replace the individuals of the species with n new ones. Individual i
+       gets age base + i and relative size (base + i) / 10. */
+    static void setIndividuals(int n, int base) {
+        IndivType *prev = NULL;
+
+        Indiv_Clear(Species[0]);
+        Indiv_Reserve(Species[0], n);
+        for (int i = 0; i < n; i++) {
+            IndivType *ndv = Indiv_Alloc(Species[0]);
+            ndv->age = base + i;
+            ndv->relsize = (base + i) / 10.0f;
+            ndv->myspecies = 0;
+            ndv->Prev = prev;
+            if (prev) {
+                prev->Next = ndv;
+            } else {
+                Species[0]->IndvHead = ndv;
+            }
+            prev = ndv;
+        }
+        Species[0]->est_count = n;
+    }
+
+    /* Give every part of the plot the checkpoint holds values derived from
+       base. */
+    void setPlot(int base) {
+        setIndividuals(base + 2, base);
+        for (int a = 0; a < maxAge; a++) {
+            Species[0]->kills[a] = base + a;
+            RGroup[0]->kills[a] = 2 * base + a;
+        }
+        for (int y = 0; y < viableYears; y++) {
+            Species[0]->seedprod[y] = 3 * base + y;
+        }
+        Species[0]->lastyear_relsize = base / 4.0f;
+        RGroup[0]->res_required = base / 8.0f;
+        RGroup[0]->est_spp[0] = 0;
+        RGroup[0]->species[0] = 0;
+        Env->ppt = 100 + base;
+        Env->temp = base / 2.0f;
+        Plot->disturbed = base;
+        Succulent->prob_death = base / 16.0f;
+        for (int w = 0; w < windowSize; w++) {
+            window.ratios[w] = base + w;
+            window.transp[w] = 2 * base + w;
+            window.SoS_array[w] = 3 * base + w;
+        }
+        window.oldest_index = base % windowSize;
+        for (int y = 0; y < nYears; y++) {
+            _Grp[0].s[y].nobs = base;
+            _Grp[0].s[y].ave = base + y;
+            _Spp[0].s[y].sd = base - y;
+        }
+    }
+
+    /* Check that the plot holds the values setPlot(base) gave it. */
+    void expectPlot(int base) {
+        int n = 0;
+        for (IndivType *ndv = Species[0]->IndvHead; ndv; ndv = ndv->Next, n++) {
+            EXPECT_EQ(base + n, ndv->age);
+            EXPECT_FLOAT_EQ((base + n) / 10.0f, ndv->relsize);
+            if (ndv->Next) {
+                EXPECT_EQ(ndv, ndv->Next->Prev);
+            }
+        }
+        EXPECT_EQ(base + 2, n);
+        for (int a = 0; a < maxAge; a++) {
+            EXPECT_EQ(base + a, Species[0]->kills[a]);
+            EXPECT_EQ(2 * base + a, RGroup[0]->kills[a]);
+        }
+        for (int y = 0; y < viableYears; y++) {
+            EXPECT_EQ(3 * base + y, Species[0]->seedprod[y]);
+        }
+        EXPECT_FLOAT_EQ(base / 4.0f, Species[0]->lastyear_relsize);
+        EXPECT_FLOAT_EQ(base / 8.0f, RGroup[0]->res_required);
+        EXPECT_STREQ(speciesName, Species[0]->name);
+        EXPECT_STREQ(groupName, RGroup[0]->name);
+        EXPECT_EQ(100 + base, Env->ppt);
+        EXPECT_FLOAT_EQ(base / 2.0f, Env->temp);
+        EXPECT_EQ(base, Plot->disturbed);
+        EXPECT_FLOAT_EQ(base / 16.0f, Succulent->prob_death);
+        for (int w = 0; w < windowSize; w++) {
+            EXPECT_FLOAT_EQ(base + w, window.ratios[w]);
+            EXPECT_FLOAT_EQ(2 * base + w, window.transp[w]);
+            EXPECT_FLOAT_EQ(3 * base + w, window.SoS_array[w]);
+        }
+        EXPECT_EQ(base % windowSize, window.oldest_index);
+        for (int y = 0; y < nYears; y++) {
+            EXPECT_EQ(base, _Grp[0].s[y].nobs);
+            EXPECT_DOUBLE_EQ(base + y, _Grp[0].s[y].ave);
+            EXPECT_DOUBLE_EQ(base - y, _Spp[0].s[y].sd);
+        }
+    }
+
+    void writeCheckpoint(IntS iterationsDone, unsigned int inputChecksum) {
+        CheckpointHeader header;
+
+        checkpoint_InitHeader(&header, 1, 1, 0, 1, inputChecksum);
+        header.iterationsDone = iterationsDone;
+        FILE *f = checkpoint_Create(fileName, &header);
+        ASSERT_TRUE(checkpoint_WritePlot(f));
+        checkpoint_Commit(f, fileName);
+    }
+
+    /* Returns the iterations the checkpoint covers. */
+    IntS readCheckpoint(unsigned int inputChecksum) {
+        CheckpointHeader header;
+
+        checkpoint_InitHeader(&header, 1, 1, 0, 1, inputChecksum);
+        FILE *f = checkpoint_Open(fileName, &header);
+        EXPECT_TRUE(checkpoint_ReadPlot(f));
+        fclose(f);
+        return header.iterationsDone;
+    }
+};
+
+TEST_F(CheckpointTest, ReadRestoresWhatWasWritten) {
+    setPlot(3);
+    writeCheckpoint(2, 7);
+
+    setPlot(9);
+    EXPECT_EQ(2, readCheckpoint(7));
+    expectPlot(3);
+}
+
+TEST_F(CheckpointTest, ReadRestoresMoreIndividualsThanThePlotHas) {
+    setPlot(20);
+    writeCheckpoint(1, 7);
+
+    setPlot(1);
+    readCheckpoint(7);
+    expectPlot(20);
+}
+
+TEST_F(CheckpointTest, OpenFailsForAnotherSeed) {
+    setPlot(3);
+    writeCheckpoint(2, 7);
+
+    SuperGlobals.randseed = -43;
+    EXPECT_EXIT(readCheckpoint(7), ::testing::ExitedWithCode(1), "written with seed 42");
+}
+
+TEST_F(CheckpointTest, OpenFailsForOtherInputs) {
+    setPlot(3);
+    writeCheckpoint(2, 7);
+
+    EXPECT_EXIT(readCheckpoint(8), ::testing::ExitedWithCode(1), "input files changed");
+}
+
+TEST_F(CheckpointTest, OpenFailsForAnotherNumberOfYears) {
+    setPlot(3);
+    writeCheckpoint(2, 7);
+
+    SuperGlobals.runModelYears = nYears + 1;
+    EXPECT_EXIT(readCheckpoint(7), ::testing::ExitedWithCode(1), "different inputs");
+}
+
+TEST(CheckpointChecksumTest, ChecksumFollowsTheFileContents) {
+    char name[] = "/tmp/stepwat_test_checksumXXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_NE(fd, -1);
+    ASSERT_EQ(3, write(fd, "abc", 3));
+    close(fd);
+
+    unsigned int first = checkpoint_ChecksumFile(CHECKPOINT_CHECKSUM_START, name);
+    EXPECT_EQ(first, checkpoint_ChecksumFile(CHECKPOINT_CHECKSUM_START, name));
+    // FNV-1a of "abc"
+    EXPECT_EQ(0x1A47E90Bu, first);
+
+    FILE *f = fopen(name, "w");
+    fputs("abd", f);
+    fclose(f);
+    EXPECT_NE(first, checkpoint_ChecksumFile(CHECKPOINT_CHECKSUM_START, name));
+    unlink(name);
+}
+
+}  // namespace
@@ -0,0 +1,22 @@
+#ifndef TEST_ST_CHECKPOINT_H
+#define TEST_ST_CHECKPOINT_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_defines.h"
+#include "ST_globals.h"
+#include "ST_functions.h"
+#include "ST_stats.h"
+#include "ST_checkpoint.h"
+#include "sxw.h"
+
+// From sxw.c
+void copy_sxw_variables(SXW_t* newSXW, SXW_resourceType* newSXWResources, transp_t* newTransp_window);
+}
+
+// From ST_stats.c
+extern "C" StatType *_Grp, *_Spp;
+
+#endif
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+#include "test_ST_context.h"
+
+namespace {
+
+const int nDraws = 8;
+
+class StreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        useRNGStreams = (Bool) TRUE;
+        QuietMode = (Bool) TRUE;
+        SuperGlobals.randseed = -42;
+        SimContext_SetSeed();
+    }
+
+    void TearDown() override {
+        useRNGStreams = (Bool) FALSE;
+        QuietMode = (Bool) FALSE;
+        SuperGlobals.randseed = 0;
+    }
+
+    static std::vector<uint32_t> draws(unsigned long cell, IntS iter, int subsystem) {
+        pcg32_random_t rng;
+        std::vector<uint32_t> result;
+
+        SimContext_SeedStream(&rng, cell, iter, (RNG_Subsystem) subsystem);
+        for (int i = 0; i < nDraws; i++) {
+            result.push_back(pcg32_random_r(&rng));
+        }
+        return result;
+    }
+};
+
+TEST_F(StreamTest, StreamDoesNotDependOnOtherStreams) {
+    std::vector<uint32_t> expected = draws(7, 3, RNG_SPECIES);
+    pcg32_random_t other;
+
+    // Seed and use other streams first, in another order.
+    SimContext_SeedStream(&other, 7, 3, (RNG_Subsystem) RNG_MORTALITY);
+    pcg32_random_r(&other);
+    draws(0, 1, RNG_GRID);
+    draws(7, 2, RNG_SPECIES);
+
+    EXPECT_EQ(expected, draws(7, 3, RNG_SPECIES));
+}
+
+TEST_F(StreamTest, EveryCellIterationAndSubsystemHasItsOwnStream) {
+    std::set<std::vector<uint32_t>> seen;
+    int n = 0;
+
+    for (unsigned long cell : {0UL, 1UL, 2UL, 1000UL}) {
+        for (IntS iter : {0, 1, 2, 100}) {
+            for (int subsystem = 0; subsystem < N_RNG_SUBSYSTEMS; subsystem++) {
+                seen.insert(draws(cell, iter, subsystem));
+                n++;
+            }
+        }
+    }
+    EXPECT_EQ((size_t) n, seen.size());
+}
+
+TEST_F(StreamTest, StreamsDependOnTheSeed) {
+    std::vector<uint32_t> first = draws(1, 1, RNG_ENVIRONS);
+
+    SuperGlobals.randseed = -43;
+    SimContext_SetSeed();
+    EXPECT_NE(first, draws(1, 1, RNG_ENVIRONS));
+
+    SuperGlobals.randseed = -42;
+    SimContext_SetSeed();
+    EXPECT_EQ(first, draws(1, 1, RNG_ENVIRONS));
+}
+
+TEST_F(StreamTest, ClockSeedIsDrawnOnceAndKept) {
+    SuperGlobals.randseed = 0;
+    SimContext_SetSeed();
+    IntL resolved = SuperGlobals.randseed;
+    std::vector<uint32_t> first = draws(1, 1, RNG_ENVIRONS);
+
+    EXPECT_LT(resolved, 0);
+    EXPECT_EQ(first, draws(1, 1, RNG_ENVIRONS));
+
+    // Putting the resolved seed back into the input repeats the run.
+    SuperGlobals.randseed = resolved;
+    SimContext_SetSeed();
+    EXPECT_EQ(first, draws(1, 1, RNG_ENVIRONS));
+}
+
+TEST_F(StreamTest, ClockSeedIsKeptWithoutStreams) {
+    useRNGStreams = (Bool) FALSE;
+    SuperGlobals.randseed = 0;
+    SimContext_SetSeed();
+    EXPECT_EQ(0, SuperGlobals.randseed);
+}
+
+TEST(InputSeedTest, ShowsTheSeedOfTheInputFile) {
+    // ST_params.c stores the seed 42 of the input file as -42.
+    EXPECT_EQ(42, SimContext_InputSeed(-42));
+    EXPECT_EQ(42, SimContext_InputSeed(42));
+    EXPECT_EQ(0, SimContext_InputSeed(0));
+}
+
+TEST_F(StreamTest, StreamsOutsideTheIdRangeAreFatal) {
+    EXPECT_EXIT(draws(0, -1, RNG_ENVIRONS), ::testing::ExitedWithCode(1), "");
+    EXPECT_EXIT(draws(1UL << 35, 1, RNG_ENVIRONS), ::testing::ExitedWithCode(1), "");
+    EXPECT_EXIT(draws(0, 1, 16), ::testing::ExitedWithCode(1), "");
+}
+
+}  // namespace
@@ -0,0 +1,16 @@
+#ifndef TEST_ST_CONTEXT_H
+#define TEST_ST_CONTEXT_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_defines.h"
+#include "ST_globals.h"
+#include "ST_context.h"
+}
+
+// From ST_main.c
+extern "C" Bool QuietMode;
+
+#endif
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "test_ST_grid.h"
+
+namespace {
+
+const int nYears = 2;
+
+/* A grid of one row and three cells with one group and one species. Every
+   cell collects group and species biomass. Cells have no SOILWAT2 state, so
+   load_cell() only swaps the STEPPE state. */
+class CellShardTest : public ::testing::Test {
+protected:
+    char groupName[5] = "grp1";
+    char speciesName[5] = "spp1";
+    char prefix[64];
+
+    void SetUp() override {
+        strcpy(prefix, "/tmp/stepwat_test_shardXXXXXX");
+        int fd = mkstemp(prefix);
+        ASSERT_NE(fd, -1);
+        close(fd);
+        unlink(prefix);
+
+        SuperGlobals.runModelYears = nYears;
+        BmassFlags = BmassFlagsType();
+        BmassFlags.grpb = (Bool) TRUE;
+        BmassFlags.sppb = (Bool) TRUE;
+        MortFlags = MortFlagsType();
+        UseSeedDispersal = (Bool) FALSE;
+
+        grid_Rows = 1;
+        grid_Cols = 3;
+        grid_Cells = 3;
+        grid_files[GRID_FILE_PREFIX_BMASSCELLAVG] = prefix;
+        gridCells = (CellType **)Mem_Calloc(grid_Rows, sizeof(CellType *), nullptr);
+        gridCells[0] = (CellType *)Mem_Calloc(grid_Cols, sizeof(CellType), nullptr);
+
+        for (int j = 0; j < grid_Cols; j++) {
+            CellType *cell = &gridCells[0][j];
+            cell->myGlobals.grpCount = 1;
+            cell->myGlobals.sppCount = 1;
+            cell->myGroup = (GroupType **)Mem_Calloc(1, sizeof(GroupType *), nullptr);
+            cell->myGroup[0] = (GroupType *)Mem_Calloc(1, sizeof(GroupType), nullptr);
+            cell->myGroup[0]->name = groupName;
+            cell->mySpecies = (SpeciesType **)Mem_Calloc(1, sizeof(SpeciesType *), nullptr);
+            cell->mySpecies[0] = (SpeciesType *)Mem_Calloc(1, sizeof(SpeciesType), nullptr);
+            cell->mySpecies[0]->name = speciesName;
+            cell->_Grp = newStat();
+            cell->_Spp = newStat();
+        }
+    }
+
+    void TearDown() override {
+        for (int j = 0; j < grid_Cols; j++) {
+            CellType *cell = &gridCells[0][j];
+            freeStat(cell->_Grp);
+            freeStat(cell->_Spp);
+            Mem_Free(cell->mySpecies[0]);
+            Mem_Free(cell->mySpecies);
+            Mem_Free(cell->myGroup[0]);
+            Mem_Free(cell->myGroup);
+        }
+        Mem_Free(gridCells[0]);
+        Mem_Free(gridCells);
+        gridCells = NULL;
+        grid_files[GRID_FILE_PREFIX_BMASSCELLAVG] = NULL;
+        useCellRange = (Bool) FALSE;
+
+        for (int begin : {0, 1, 2}) {
+            unlink(shardName(begin).c_str());
+        }
+    }
+
+    static StatType *newStat() {
+        StatType *stat = (StatType *)Mem_Calloc(1, sizeof(StatType), nullptr);
+        stat->s = (struct accumulators_st *)Mem_Calloc(nYears, sizeof(struct accumulators_st), nullptr);
+        return stat;
+    }
+
+    static void freeStat(StatType *stat) {
+        Mem_Free(stat->s);
+        Mem_Free(stat);
+    }
+
+    std::string shardName(int begin) {
+        return std::string(prefix) + "_cells" + std::to_string(begin) + ".bin";
+    }
+
+    /* Give every accumulator of cell j values no other accumulator has. */
+    static void fillCell(int j) {
+        for (int y = 0; y < nYears; y++) {
+            struct accumulators_st *grp = &gridCells[0][j]._Grp->s[y];
+            struct accumulators_st *spp = &gridCells[0][j]._Spp->s[y];
+            grp->nobs = spp->nobs = 3 + j;
+            grp->ave = 10.0 * j + y;
+            grp->sum_dif_sqr = 0.5 * j + y;
+            grp->sd = 0.25 * j + y;
+            spp->ave = -10.0 * j - y;
+            spp->sum_dif_sqr = 1.5 * j + y;
+            spp->sd = 0.75 * j + y;
+        }
+    }
+
+    /* What a process started with --cells=begin:end writes. */
+    static void writeShard(int begin, int end) {
+        useCellRange = (Bool) TRUE;
+        cellRangeBegin = begin;
+        cellRangeEnd = end;
+        write_cell_shard();
+        useCellRange = (Bool) FALSE;
+    }
+};
+
+TEST_F(CellShardTest, MergeRestoresTheAccumulatorsOfEveryCell) {
+    std::vector<struct accumulators_st> expected;
+
+    for (int j = 0; j < grid_Cols; j++) {
+        fillCell(j);
+        for (int y = 0; y < nYears; y++) {
+            expected.push_back(gridCells[0][j]._Grp->s[y]);
+            expected.push_back(gridCells[0][j]._Spp->s[y]);
+        }
+    }
+    writeShard(0, 2);
+    writeShard(2, 3);
+
+    for (int j = 0; j < grid_Cols; j++) {
+        memset(gridCells[0][j]._Grp->s, 0, nYears * sizeof(struct accumulators_st));
+        memset(gridCells[0][j]._Spp->s, 0, nYears * sizeof(struct accumulators_st));
+    }
+    merge_cell_shards();
+
+    size_t k = 0;
+    for (int j = 0; j < grid_Cols; j++) {
+        for (int y = 0; y < nYears; y++) {
+            EXPECT_EQ(0, memcmp(&gridCells[0][j]._Grp->s[y], &expected[k++], sizeof(struct accumulators_st)))
+                << "group accumulator of cell " << j << ", year " << y;
+            EXPECT_EQ(0, memcmp(&gridCells[0][j]._Spp->s[y], &expected[k++], sizeof(struct accumulators_st)))
+                << "species accumulator of cell " << j << ", year " << y;
+        }
+    }
+}
+
+TEST_F(CellShardTest, MergeFailsIfAShardIsMissing) {
+    writeShard(0, 2);
+    EXPECT_EXIT(merge_cell_shards(), ::testing::ExitedWithCode(1), "No shard file");
+}
+
+TEST_F(CellShardTest, MergeFailsIfAShardBelongsToAnotherRun) {
+    writeShard(0, 2);
+    SuperGlobals.runModelYears = nYears + 1;
+    writeShard(2, 3);
+    SuperGlobals.runModelYears = nYears;
+    EXPECT_EXIT(merge_cell_shards(), ::testing::ExitedWithCode(1), "does not match this grid");
+}
+
+TEST_F(CellShardTest, MergeFailsIfAShardWasWrittenWithAnotherSeed) {
+    SuperGlobals.randseed = -1;
+    writeShard(0, 2);
+    SuperGlobals.randseed = -2;
+    writeShard(2, 3);
+    EXPECT_EXIT(merge_cell_shards(), ::testing::ExitedWithCode(1), "written with seed 1");
+    SuperGlobals.randseed = 0;
+}
+
+}  // namespace
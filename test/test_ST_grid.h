@@ -0,0 +1,18 @@
+#ifndef TEST_ST_GRID_H
+#define TEST_ST_GRID_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_defines.h"
+#include "ST_globals.h"
+#include "ST_grid.h"
+}
+
+// From ST_grid.c
+extern int grid_Cells;
+extern void (*write_cell_shard)(void);
+extern void (*merge_cell_shards)(void);
+
+#endif
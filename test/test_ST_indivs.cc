@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "test_ST_indivs.h"
+
+namespace {
+
+/* An individual and its position in the unsorted list. */
+struct Entry {
+    IndivType *ndv;
+    size_t index;
+};
+
+int compareEntryA(const void *key1, const void *key2) {
+    const Entry *a = (const Entry *)key1, *b = (const Entry *)key2;
+    int r = Indiv_CompSize_A(&a->ndv, &b->ndv);
+    return r ? r : (a->index < b->index ? -1 : 1);
+}
+
+int compareEntryD(const void *key1, const void *key2) {
+    const Entry *a = (const Entry *)key1, *b = (const Entry *)key2;
+    int r = Indiv_CompSize_D(&a->ndv, &b->ndv);
+    return r ? r : (a->index < b->index ? -1 : 1);
+}
+
+/* n individuals whose sizes take only a few distinct values, so most of
+   them tie with others. */
+std::vector<IndivType> tiedIndividuals(size_t n, unsigned seed) {
+    std::vector<IndivType> indivs(n);
+    srand(seed);
+    for (size_t i = 0; i < n; i++) {
+        indivs[i] = IndivType();
+        indivs[i].relsize = (rand() % 5) / 4.0f;
+    }
+    return indivs;
+}
+
+std::vector<IndivType *> pointersTo(std::vector<IndivType> &indivs) {
+    std::vector<IndivType *> list;
+    for (IndivType &ndv : indivs) {
+        list.push_back(&ndv);
+    }
+    return list;
+}
+
+/* The order qsort() gives when ties are broken by list position, i.e. the
+   order of a stable sort. */
+std::vector<IndivType *> stableQsort(const std::vector<IndivType *> &list, byte sorttype) {
+    std::vector<Entry> entries;
+    std::vector<IndivType *> sorted;
+
+    for (size_t i = 0; i < list.size(); i++) {
+        entries.push_back({list[i], i});
+    }
+    qsort(entries.data(), entries.size(), sizeof(Entry),
+          sorttype == SORT_A ? compareEntryA : compareEntryD);
+    for (const Entry &e : entries) {
+        sorted.push_back(e.ndv);
+    }
+    return sorted;
+}
+
+TEST(IndivSortTest, TiesKeepTheirListOrder) {
+    for (byte sorttype : {(byte) SORT_A, (byte) SORT_D}) {
+        for (size_t n : {1, 2, 7, 64, 1000}) {
+            std::vector<IndivType> indivs = tiedIndividuals(n, (unsigned) n);
+            std::vector<IndivType *> list = pointersTo(indivs);
+            std::vector<IndivType *> scratch(n);
+            std::vector<IndivType *> expected = stableQsort(list, sorttype);
+
+            Indiv_MergeSortSize(sorttype, n, list.data(), scratch.data());
+            EXPECT_EQ(expected, list) << "sort type " << sorttype << ", " << n << " individuals";
+        }
+    }
+}
+
+TEST(IndivSortTest, SortedListIsOrderedBySize) {
+    std::vector<IndivType> indivs = tiedIndividuals(500, 3);
+    std::vector<IndivType *> list = pointersTo(indivs);
+    std::vector<IndivType *> scratch(list.size());
+
+    Indiv_MergeSortSize(SORT_D, list.size(), list.data(), scratch.data());
+    for (size_t i = 1; i < list.size(); i++) {
+        EXPECT_GE(list[i - 1]->relsize, list[i]->relsize);
+    }
+}
+
+TEST(IndivSortTest, ResortMatchesTheMergeSort) {
+    std::vector<IndivType> indivs = tiedIndividuals(200, 15);
+    std::vector<IndivType *> list = pointersTo(indivs), expected = stableQsort(list, SORT_D);
+    std::vector<int> pos(list.size());
+
+    // Start from the sorted order with a few individuals out of place, and
+    // pos their positions in the unsorted list.
+    std::vector<IndivType *> start = expected;
+    std::swap(start[3], start[40]);
+    std::swap(start[100], start[101]);
+    for (size_t i = 0; i < start.size(); i++) {
+        pos[i] = (int) (start[i] - &indivs[0]);
+    }
+
+    ASSERT_TRUE(Indiv_ResortSize(SORT_D, start.size(), start.data(), pos.data(), 1000));
+    EXPECT_EQ(expected, start);
+}
+
+TEST(IndivSortTest, ResortGivesUpAfterMaxShifts) {
+    std::vector<IndivType> indivs(10);
+    std::vector<int> pos(indivs.size());
+    for (size_t i = 0; i < indivs.size(); i++) {
+        indivs[i] = IndivType();
+        indivs[i].relsize = i / 10.0f;
+        pos[i] = (int) i;
+    }
+    std::vector<IndivType *> list = pointersTo(indivs);
+
+    // Descending order takes 45 shifts from ascending order.
+    EXPECT_FALSE(Indiv_ResortSize(SORT_D, list.size(), list.data(), pos.data(), 44));
+}
+
+/* One species with its individual storage, and nothing else. */
+class IndivStorageTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        SuperGlobals.max_indivs_per_spp = 1000;
+        Species = (SpeciesType **)Mem_Calloc(1, sizeof(SpeciesType *), nullptr);
+        Species[0] = (SpeciesType *)Mem_Calloc(1, sizeof(SpeciesType), nullptr);
+        s = Species[0];
+        s->relseedlingsize = 0.25;
+    }
+
+    void TearDown() override {
+        Indiv_FreeStorage(s);
+        Mem_Free(Species[0]);
+        Mem_Free(Species);
+        Species = NULL;
+    }
+
+    /* Establish n individuals. Each gets relsize 1 + its position in the
+       order of establishment, so they can be told apart. */
+    void establish(int n) {
+        for (int i = 0; i < n; i++) {
+            indiv_New(0);
+            s->est_count++;
+            Indiv_SetRelsize(s->IndvHead, 1.0f + i);
+        }
+    }
+
+    std::vector<RealF> listSizes() {
+        std::vector<RealF> sizes;
+        for (IndivType *p = s->IndvHead; p != NULL; p = p->Next) {
+            sizes.push_back(p->relsize);
+        }
+        return sizes;
+    }
+
+    /* The packed array holds the list in order, linked both ways. */
+    void expectPacked(const std::vector<RealF> &sizes) {
+        int n;
+        IndivType *indivs = Indiv_Pack(s, &n);
+        double total = 0;
+
+        ASSERT_EQ((int) sizes.size(), n);
+        EXPECT_EQ(s->est_count, n);
+        EXPECT_EQ(n ? indivs : NULL, s->IndvHead);
+        for (int i = 0; i < n; i++) {
+            EXPECT_EQ(sizes[i], indivs[i].relsize) << "individual " << i;
+            EXPECT_EQ(i > 0 ? &indivs[i - 1] : NULL, indivs[i].Prev);
+            EXPECT_EQ(i < n - 1 ? &indivs[i + 1] : NULL, indivs[i].Next);
+            total += indivs[i].relsize;
+        }
+        EXPECT_DOUBLE_EQ(total, s->indivs_relsize);
+    }
+
+    SpeciesType *s;
+};
+
+TEST_F(IndivStorageTest, DeleteFromTheMiddleThenCompact) {
+    establish(7);
+    // Newer individuals are at the head of the list.
+    EXPECT_EQ(std::vector<RealF>({7, 6, 5, 4, 3, 2, 1}), listSizes());
+
+    // Kill the fourth and the second individual of the list.
+    _delete(s->IndvHead->Next->Next->Next);
+    _delete(s->IndvHead->Next);
+    EXPECT_FALSE(s->indivsInOrder);
+
+    expectPacked({7, 5, 3, 2, 1});
+    EXPECT_TRUE(s->indivsInOrder);
+}
+
+TEST_F(IndivStorageTest, DeleteHeadAndTailThenCompact) {
+    establish(4);
+
+    IndivType *tail = s->IndvHead;
+    while (tail->Next) {
+        tail = tail->Next;
+    }
+    _delete(tail);
+    _delete(s->IndvHead);
+
+    expectPacked({3, 2});
+}
+
+TEST_F(IndivStorageTest, GrowthAfterCompactionKeepsListOrder) {
+    establish(20);
+    _delete(s->IndvHead->Next->Next);
+    expectPacked(listSizes());
+
+    // Individuals established after a compaction go to the head again,
+    // and the array is compacted once more, in list order.
+    establish(30);
+    std::vector<RealF> sizes = listSizes();
+    EXPECT_EQ(49u, sizes.size());
+    expectPacked(sizes);
+}
+
+TEST_F(IndivStorageTest, RunningTotalEqualsTheListSum) {
+    srand(13);
+    establish(50);
+
+    for (int step = 0; step < 5000; step++) {
+        // Pick a random individual to resize or kill, or establish a new one.
+        int n = s->est_count, pick = rand() % n, action = rand() % 4;
+        IndivType *ndv = s->IndvHead;
+        for (int i = 0; i < pick; i++) {
+            ndv = ndv->Next;
+        }
+
+        // The last individual is kept, so that its species stays
+        // established.
+        if (action == 0 && n > 1) {
+            _delete(ndv);
+        } else if (action == 1 && n < 200) {
+            establish(1);
+        } else {
+            Indiv_SetRelsize(ndv, 0.001f + (rand() % 1000) / 1001.0f);
+        }
+        if (step % 100 == 0) {
+            Indiv_Pack(s, &n);
+        }
+
+        // No size is below 2^-20 and the sum stays below 1024, so the
+        // running sum has no rounding error at all.
+        double total = 0;
+        for (RealF size : listSizes()) {
+            total += size;
+        }
+        ASSERT_EQ(total, s->indivs_relsize) << "step " << step;
+    }
+}
+
+/* Not a test: times Indiv_MergeSortSize() against the qsort() call it
+   replaced. Run it with `make run_benchmarks`. */
+TEST(IndivSortTest, DISABLED_BenchmarkMergeSortAgainstQsort) {
+    const int repeats = 200;
+
+    for (size_t n : {10, 100, 1000, 10000}) {
+        std::vector<IndivType> indivs(n);
+        for (size_t i = 0; i < n; i++) {
+            indivs[i] = IndivType();
+            indivs[i].relsize = rand() / (float) RAND_MAX;
+        }
+        std::vector<IndivType *> unsorted = pointersTo(indivs), list(n), scratch(n);
+        double mergeSeconds = 0, qsortSeconds = 0;
+
+        for (int r = 0; r < repeats; r++) {
+            list = unsorted;
+            auto start = std::chrono::steady_clock::now();
+            Indiv_MergeSortSize(SORT_D, n, list.data(), scratch.data());
+            mergeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            list = unsorted;
+            start = std::chrono::steady_clock::now();
+            qsort(list.data(), n, sizeof(IndivType *), Indiv_CompSize_D);
+            qsortSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        printf("%6zu individuals: Indiv_MergeSortSize %9.2f us, qsort %9.2f us\n", n,
+               1e6 * mergeSeconds / repeats, 1e6 * qsortSeconds / repeats);
+    }
+}
+
+}  // namespace
@@ -0,0 +1,17 @@
+#ifndef TEST_ST_INDIVS_H
+#define TEST_ST_INDIVS_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_defines.h"
+#include "ST_globals.h"
+#include "ST_functions.h"
+
+// From ST_indivs.c
+Bool indiv_New(SppIndex sp);
+void _delete(IndivType *ndv);
+}
+
+#endif
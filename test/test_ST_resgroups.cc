@@ -0,0 +1,427 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "test_ST_resgroups.h"
+
+namespace {
+
+/* The loop rgroup_ResPartIndiv() used before the partition kernel: every
+   individual takes what it demands while any supply is left. */
+RealF serialPartition(const std::vector<RealF> &demand, std::vector<RealF> &share,
+                      RealF supply) {
+    RealF left = supply;
+
+    for (size_t i = 0; i < demand.size(); i++) {
+        share[i] = (demand[i] < left) ? demand[i] : left;
+        left -= share[i];
+    }
+    return left;
+}
+
+std::vector<RealF> randomDemand(size_t n, unsigned seed) {
+    std::vector<RealF> demand(n);
+    srand(seed);
+    for (size_t i = 0; i < n; i++) {
+        demand[i] = (rand() % 1000) / 100.0f;
+    }
+    return demand;
+}
+
+/* Compare the kernel with the serial loop for a given demand and supply. */
+void expectSerialResult(const std::vector<RealF> &demand, RealF supply) {
+    std::vector<RealF> expected(demand.size()), share(demand.size());
+    RealF expectedLeft = serialPartition(demand, expected, supply);
+    RealF left = partition(demand.data(), share.data(), (int) demand.size(), supply);
+
+    for (size_t i = 0; i < demand.size(); i++) {
+        EXPECT_NEAR(share[i], expected[i], 1e-3) << "individual " << i;
+        EXPECT_GE(share[i], 0.);
+        EXPECT_LE(share[i], demand[i]);
+    }
+    EXPECT_NEAR(left, expectedLeft, 1e-3);
+}
+
+TEST(PartitionTest, MatchesSerialLoop) {
+    std::vector<RealF> demand = randomDemand(257, 11);
+    RealF total = 0.;
+
+    for (RealF d : demand) {
+        total += d;
+    }
+    expectSerialResult(demand, 0.25f * total);
+    expectSerialResult(demand, 0.75f * total);
+}
+
+TEST(PartitionTest, ZeroSupply) {
+    std::vector<RealF> demand = randomDemand(64, 3);
+    std::vector<RealF> share(demand.size(), -1.);
+
+    EXPECT_EQ(partition(demand.data(), share.data(), (int) demand.size(), 0.), 0.);
+    for (RealF s : share) {
+        EXPECT_EQ(s, 0.);
+    }
+}
+
+TEST(PartitionTest, SupplyExceedsDemand) {
+    std::vector<RealF> demand = {1., 2., 0., 4.};
+    std::vector<RealF> share(demand.size());
+
+    EXPECT_FLOAT_EQ(partition(demand.data(), share.data(), (int) demand.size(), 10.), 3.);
+    for (size_t i = 0; i < demand.size(); i++) {
+        EXPECT_FLOAT_EQ(share[i], demand[i]);
+    }
+}
+
+TEST(PartitionTest, SupplyRunsOutPartway) {
+    std::vector<RealF> demand = {1., 2., 3., 4.};
+    std::vector<RealF> share(demand.size());
+
+    // The third individual gets what is left and the fourth nothing.
+    EXPECT_EQ(partition(demand.data(), share.data(), (int) demand.size(), 4.5), 0.);
+    EXPECT_FLOAT_EQ(share[0], 1.);
+    EXPECT_FLOAT_EQ(share[1], 2.);
+    EXPECT_FLOAT_EQ(share[2], 1.5);
+    EXPECT_FLOAT_EQ(share[3], 0.);
+}
+
+TEST(PartitionTest, NoIndividuals) {
+    EXPECT_FLOAT_EQ(partition(NULL, NULL, 0, 5.), 5.);
+}
+
+/* One group with established species whose individuals grow, die and
+   establish from one year to the next. */
+class SortedIndexTest : public ::testing::Test {
+protected:
+    static const int nSpecies = 3;
+
+    void SetUp() override {
+        SuperGlobals.max_indivs_per_spp = 20000;
+
+        RGroup = (GroupType **)Mem_Calloc(1, sizeof(GroupType *), nullptr);
+        RGroup[0] = (GroupType *)Mem_Calloc(1, sizeof(GroupType), nullptr);
+        RGroup[0]->est_spp = (SppIndex *)Mem_Calloc(nSpecies + 1, sizeof(SppIndex), nullptr);
+        RGroup[0]->est_count = nSpecies;
+
+        Species = (SpeciesType **)Mem_Calloc(nSpecies, sizeof(SpeciesType *), nullptr);
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            Species[sp] = (SpeciesType *)Mem_Calloc(1, sizeof(SpeciesType), nullptr);
+            Species[sp]->relseedlingsize = 0.01f * (sp + 1);
+            RGroup[0]->est_spp[sp] = sp;
+        }
+    }
+
+    void TearDown() override {
+        scratch_Reset();
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            Indiv_FreeStorage(Species[sp]);
+            Mem_Free(Species[sp]);
+        }
+        Mem_Free(Species);
+        Species = NULL;
+        Mem_Free(RGroup[0]->sorted);
+        Mem_Free(RGroup[0]->sortScratch);
+        Mem_Free(RGroup[0]->est_spp);
+        Mem_Free(RGroup[0]);
+        Mem_Free(RGroup);
+        RGroup = NULL;
+    }
+
+    /* Establish n seedlings in a species. They all have the same size. */
+    void establish(SppIndex sp, int n) {
+        for (int i = 0; i < n; i++) {
+            indiv_New(sp);
+            Species[sp]->est_count++;
+        }
+    }
+
+    /* Grow every individual by a random amount. If round, some sizes are
+       rounded, so that individuals of different species end up the same
+       size. */
+    void grow(int maxPercent, bool round = true) {
+        IndivType *ndv;
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            ForEachIndiv(ndv, Species[sp]) {
+                RealF size = ndv->relsize * (1 + (rand() % (maxPercent + 1)) / 100.0f);
+                if (round && rand() % 10 == 0) {
+                    size = ((int) (size * 8)) / 8.0f;
+                }
+                Indiv_SetRelsize(ndv, size > 0 ? (size < 1 ? size : 1) : 0.01f);
+            }
+        }
+    }
+
+    /* Kill about one in every `in` individuals, but keep every species. */
+    void kill(int in) {
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            IndivType *ndv = Species[sp]->IndvHead, *next;
+            while (ndv != NULL) {
+                next = ndv->Next;
+                if (rand() % in == 0 && Species[sp]->est_count > 1) {
+                    _delete(ndv);
+                }
+                ndv = next;
+            }
+        }
+    }
+
+    /* What a sort of the lists of the species from scratch gives. */
+    std::vector<IndivType *> sortedFromScratch(byte sort) {
+        std::vector<IndivType *> list, scratch;
+        IndivType *ndv;
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            ForEachIndiv(ndv, Species[sp]) {
+                list.push_back(ndv);
+            }
+        }
+        scratch.resize(list.size());
+        Indiv_MergeSortSize(sort, list.size(), list.data(), scratch.data());
+        return list;
+    }
+
+    void expectSortedFromScratch(byte sort, int year) {
+        IntS n;
+        IndivType **sorted = RGroup_SortedIndivs(0, sort, &n);
+        std::vector<IndivType *> expected = sortedFromScratch(sort);
+
+        ASSERT_EQ(expected.size(), (size_t) n) << "year " << year;
+        for (IntS i = 0; i < n; i++) {
+            ASSERT_EQ(expected[i], sorted[i]) << "year " << year << ", individual " << i;
+        }
+    }
+};
+
+TEST_F(SortedIndexTest, MatchesASortFromScratchEveryYear) {
+    srand(15);
+    for (SppIndex sp = 0; sp < nSpecies; sp++) {
+        establish(sp, 40);
+    }
+
+    for (int year = 0; year < 100; year++) {
+        // The order of the calls in a year: resources, growth, mortality
+        expectSortedFromScratch(SORT_D, year);
+        expectSortedFromScratch(SORT_D, year);
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            int n;
+            Indiv_Pack(Species[sp], &n);
+        }
+        grow(year % 10 == 0 ? 100 : 5);
+        expectSortedFromScratch(SORT_A, year);
+        kill(8);
+        expectSortedFromScratch(SORT_A, year);
+        establish(year % nSpecies, rand() % 20);
+        scratch_Reset();
+    }
+}
+
+TEST_F(SortedIndexTest, StartsOverWhenTheGroupIsReplaced) {
+    establish(0, 30);
+    establish(1, 30);
+    grow(50);
+    expectSortedFromScratch(SORT_D, 0);
+
+    // Ranks that belong to another list must not confuse the next sort.
+    IndivType *ndv;
+    ForEachIndiv(ndv, Species[1]) {
+        ndv->sortRank = 3;
+    }
+    RGroup_InvalidateSorted(RGroup[0]);
+    expectSortedFromScratch(SORT_D, 1);
+    expectSortedFromScratch(SORT_A, 1);
+}
+
+/* Not a test: times RGroup_SortedIndivs() after a year of growth against
+   a sort from scratch, for slow and for fast changes of size. Run it with
+   `make run_benchmarks`. */
+TEST_F(SortedIndexTest, DISABLED_BenchmarkAgainstSortFromScratch) {
+    const int repeats = 200;
+    int established = 0;
+
+    srand(15);
+    for (int n : {100, 1000, 10000}) {
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            establish(sp, n - established);
+        }
+        established = n;
+
+        for (int perMille : {1, 20}) {
+            grow(100, false);
+
+            double resortSeconds = 0, scratchSeconds = 0;
+            IntS num;
+            for (int r = 0; r < repeats; r++) {
+                RGroup_SortedIndivs(0, SORT_D, &num);
+
+                IndivType *ndv;
+                for (SppIndex sp = 0; sp < nSpecies; sp++) {
+                    ForEachIndiv(ndv, Species[sp]) {
+                        RealF size = ndv->relsize * (1 + (rand() % (2 * perMille + 1) - perMille) / 1000.0f);
+                        Indiv_SetRelsize(ndv, size < 1 ? size : 1);
+                    }
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                RGroup_SortedIndivs(0, SORT_D, &num);
+                resortSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                start = std::chrono::steady_clock::now();
+                sortedFromScratch(SORT_D);
+                scratchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                scratch_Reset();
+            }
+            printf("%6d individuals, sizes change by up to %2d per mille: "
+                   "RGroup_SortedIndivs %9.2f us, sort from scratch %9.2f us\n",
+                   nSpecies * n, perMille, 1e6 * resortSeconds / repeats, 1e6 * scratchSeconds / repeats);
+        }
+    }
+}
+
+/* The loop _extra_growth() used before it was made linear: every
+   individual updated the share of every individual in the group. */
+void quadraticExtraGrowth(GrpIndex rg) {
+    Int j;
+    RealF extra_ndv, indivpergram;
+    GroupType *g = RGroup[rg];
+    IndivType *ndv;
+    SppIndex sp;
+
+    ForEachEstSpp(sp, rg, j) {
+        Species[sp]->extragrowth = 0.0;
+        indivpergram = 1.0 / Species[sp]->mature_biomass;
+
+        ForEachIndiv(ndv, Species[sp]) {
+            RGroup_Update_GrpResProp(rg);
+            ndv->res_extra = ndv->grp_res_prop * g->res_extra;
+            extra_ndv = ndv->res_extra * g->xgrow * indivpergram;
+            extra_ndv = GT(extra_ndv, 1 - ndv->relsize) ? 1 - ndv->relsize : extra_ndv;
+            Species[sp]->extragrowth += extra_ndv;
+        }
+    }
+}
+
+/* One group with established species that take extra resources. */
+class ExtraGrowthTest : public ::testing::Test {
+protected:
+    static const int nSpecies = 3;
+
+    void SetUp() override {
+        SuperGlobals.max_indivs_per_spp = 20000;
+
+        RGroup = (GroupType **)Mem_Calloc(1, sizeof(GroupType *), nullptr);
+        RGroup[0] = (GroupType *)Mem_Calloc(1, sizeof(GroupType), nullptr);
+        RGroup[0]->est_spp = (SppIndex *)Mem_Calloc(nSpecies + 1, sizeof(SppIndex), nullptr);
+        RGroup[0]->est_count = nSpecies;
+        RGroup[0]->use_extra_res = (Bool) TRUE;
+        RGroup[0]->res_extra = 0.3;
+        RGroup[0]->xgrow = 0.5;
+
+        Species = (SpeciesType **)Mem_Calloc(nSpecies, sizeof(SpeciesType *), nullptr);
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            Species[sp] = (SpeciesType *)Mem_Calloc(1, sizeof(SpeciesType), nullptr);
+            Species[sp]->mature_biomass = 10. * (sp + 1);
+            Species[sp]->relseedlingsize = 0.01;
+            RGroup[0]->est_spp[sp] = sp;
+        }
+    }
+
+    void TearDown() override {
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            Indiv_FreeStorage(Species[sp]);
+            Mem_Free(Species[sp]);
+        }
+        Mem_Free(Species);
+        Species = NULL;
+        Mem_Free(RGroup[0]->est_spp);
+        Mem_Free(RGroup[0]);
+        Mem_Free(RGroup);
+        RGroup = NULL;
+    }
+
+    /* Establish n individuals of random size in every species. */
+    void populate(int n, unsigned seed) {
+        srand(seed);
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            for (int i = 0; i < n; i++) {
+                indiv_New(sp);
+                Species[sp]->est_count++;
+                Indiv_SetRelsize(Species[sp]->IndvHead, 0.01f + (rand() % 990) / 1000.0f);
+            }
+        }
+    }
+
+    /* Both versions start from the extra growth left from last year. */
+    void setLastYearsExtraGrowth() {
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            Species[sp]->extragrowth = 0.01f * (sp + 1);
+        }
+    }
+
+    /* Everything _extra_growth() sets, in list order. */
+    std::vector<RealF> results() {
+        std::vector<RealF> r;
+        IndivType *ndv;
+
+        for (SppIndex sp = 0; sp < nSpecies; sp++) {
+            r.push_back(Species[sp]->extragrowth);
+            ForEachIndiv(ndv, Species[sp]) {
+                r.push_back(ndv->grp_res_prop);
+                r.push_back(ndv->res_extra);
+            }
+        }
+        return r;
+    }
+};
+
+TEST_F(ExtraGrowthTest, MatchesTheQuadraticLoop) {
+    for (int n : {1, 7, 150}) {
+        populate(n, n);
+
+        setLastYearsExtraGrowth();
+        quadraticExtraGrowth(0);
+        std::vector<RealF> expected = results();
+
+        setLastYearsExtraGrowth();
+        extra_growth(0);
+        std::vector<RealF> actual = results();
+
+        // Both sum the same single precision sizes in double precision,
+        // which is exact for these sizes, so the results are equal.
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            EXPECT_EQ(expected[i], actual[i]) << "added " << n << ", value " << i;
+        }
+    }
+}
+
+/* Not a test: times _extra_growth() against the quadratic loop it
+   replaced. Run it with `make run_benchmarks`. */
+TEST_F(ExtraGrowthTest, DISABLED_BenchmarkAgainstQuadraticLoop) {
+    int established = 0;
+
+    for (int n : {100, 1000, 4000}) {
+        populate(n - established, n);
+        established = n;
+
+        setLastYearsExtraGrowth();
+        auto start = std::chrono::steady_clock::now();
+        quadraticExtraGrowth(0);
+        double quadraticSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const int repeats = 100;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            setLastYearsExtraGrowth();
+            extra_growth(0);
+        }
+        double linearSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+        printf("%6d individuals: _extra_growth %9.3f ms, quadratic loop %9.3f ms\n",
+               nSpecies * n, 1e3 * linearSeconds, 1e3 * quadraticSeconds);
+    }
+}
+
+} // namespace
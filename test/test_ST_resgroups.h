@@ -0,0 +1,23 @@
+#ifndef TEST_ST_RESGROUPS_H
+#define TEST_ST_RESGROUPS_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_defines.h"
+#include "ST_globals.h"
+#include "ST_functions.h"
+
+#include "ST_scratch.h"
+
+// From ST_indivs.c
+Bool indiv_New(SppIndex sp);
+void _delete(IndivType *ndv);
+}
+
+// From ST_resgroups.c
+extern RealF (*partition)(const RealF demand[], RealF share[], int n, RealF supply);
+extern void (*extra_growth)(GrpIndex rg);
+
+#endif
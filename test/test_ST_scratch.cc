@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "test_ST_scratch.h"
+
+namespace {
+
+/* One allocation and the byte it was filled with. */
+struct Allocation {
+    unsigned char *p;
+    size_t bytes;
+    unsigned char fill;
+};
+
+bool isZero(const void *p, size_t bytes) {
+    const unsigned char *c = (const unsigned char *)p;
+    for (size_t i = 0; i < bytes; i++) {
+        if (c[i]) return false;
+    }
+    return true;
+}
+
+bool isFilled(const Allocation &a) {
+    for (size_t i = 0; i < a.bytes; i++) {
+        if (a.p[i] != a.fill) return false;
+    }
+    return true;
+}
+
+class ScratchTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        scratch_Free();
+    }
+
+    /* Allocate and fill arrays of sizes that are not multiples of the
+       alignment, enough of them to need several blocks. */
+    std::vector<Allocation> fillArena(size_t count, size_t bytes) {
+        std::vector<Allocation> allocations;
+        for (size_t i = 0; i < count; i++) {
+            size_t n = bytes + i % 7;
+            Allocation a = {(unsigned char *)scratch_Alloc(n, 1, "ScratchTest"), n,
+                            (unsigned char)(i + 1)};
+            memset(a.p, a.fill, a.bytes);
+            allocations.push_back(a);
+        }
+        return allocations;
+    }
+};
+
+TEST_F(ScratchTest, AllocationsAreAlignedAndZeroed) {
+    for (size_t n = 1; n < 40; n++) {
+        void *p = scratch_Alloc(n, sizeof(double), "ScratchTest");
+        EXPECT_EQ((uintptr_t)p % 16, 0u);
+        EXPECT_TRUE(isZero(p, n * sizeof(double)));
+    }
+}
+
+TEST_F(ScratchTest, GrowsAcrossBlocksWithoutOverlap) {
+    // Far more than the smallest block, and a single array larger than it.
+    std::vector<Allocation> allocations = fillArena(100, 5000);
+    Allocation big = {(unsigned char *)scratch_Alloc(200000, 1, "ScratchTest"), 200000, 0xAB};
+    memset(big.p, big.fill, big.bytes);
+    allocations.push_back(big);
+
+    // Writing any allocation must not have touched another one.
+    for (const Allocation &a : allocations) {
+        EXPECT_TRUE(isFilled(a));
+        EXPECT_EQ((uintptr_t)a.p % 16, 0u);
+    }
+}
+
+TEST_F(ScratchTest, ResetReusesMemoryAndZeroesIt) {
+    fillArena(100, 5000);
+    scratch_Reset();
+
+    // After the reset the chain is merged into one block, so the same year
+    // fits again and starts at the same address every time.
+    std::vector<Allocation> first = fillArena(100, 5000);
+    scratch_Reset();
+    std::vector<Allocation> second = fillArena(100, 5000);
+
+    ASSERT_EQ(first.size(), second.size());
+    for (size_t i = 0; i < first.size(); i++) {
+        EXPECT_EQ(first[i].p, second[i].p);
+    }
+
+    // Memory handed out again is zeroed, although it was filled before.
+    scratch_Reset();
+    void *p = scratch_Alloc(5000, 1, "ScratchTest");
+    EXPECT_EQ(p, (void *)first[0].p);
+    EXPECT_TRUE(isZero(p, 5000));
+}
+
+TEST_F(ScratchTest, ResetAndFreeOnEmptyArena) {
+    scratch_Reset();
+    scratch_Free();
+    EXPECT_TRUE(isZero(scratch_Alloc(10, 1, "ScratchTest"), 10));
+}
+
+} // namespace
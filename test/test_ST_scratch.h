@@ -0,0 +1,11 @@
+#ifndef TEST_ST_SCRATCH_H
+#define TEST_ST_SCRATCH_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_scratch.h"
+}
+
+#endif
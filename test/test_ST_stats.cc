@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "test_ST_stats.h"
+
+namespace {
+
+const int nYears = 3;
+
+/* Sets up one group and one species that collect group biomass, species
+   biomass and received seed probability. The accumulators are allocated by
+   ST_stats.c the first time they are used. */
+class AccumulatorTest : public ::testing::Test {
+protected:
+    char groupName[5] = "grp1";
+    char speciesName[5] = "spp1";
+
+    void SetUp() override {
+        SuperGlobals.runModelYears = nYears;
+        UseGrid = (Bool) TRUE;
+        UseSeedDispersal = (Bool) TRUE;
+        BmassFlags = BmassFlagsType();
+        BmassFlags.grpb = (Bool) TRUE;
+        BmassFlags.sppb = (Bool) TRUE;
+        MortFlags = MortFlagsType();
+
+        Globals = (ModelType *)Mem_Calloc(1, sizeof(ModelType), nullptr);
+        Globals->grpCount = 1;
+        Globals->sppCount = 1;
+        RGroup = (GroupType **)Mem_Calloc(1, sizeof(GroupType *), nullptr);
+        RGroup[0] = (GroupType *)Mem_Calloc(1, sizeof(GroupType), nullptr);
+        RGroup[0]->name = groupName;
+        Species = (SpeciesType **)Mem_Calloc(1, sizeof(SpeciesType *), nullptr);
+        Species[0] = (SpeciesType *)Mem_Calloc(1, sizeof(SpeciesType), nullptr);
+        Species[0]->name = speciesName;
+
+        stat_Copy_Accumulators(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, (Bool) TRUE);
+        stat_Clear_Accumulators();
+        file = tmpfile();
+        ASSERT_NE(file, nullptr);
+    }
+
+    void TearDown() override {
+        fclose(file);
+        stat_free_mem();
+        Mem_Free(Species[0]);
+        Mem_Free(Species);
+        Mem_Free(RGroup[0]);
+        Mem_Free(RGroup);
+        Mem_Free(Globals);
+        UseGrid = (Bool) FALSE;
+        UseSeedDispersal = (Bool) FALSE;
+    }
+
+    /* Every accumulator _transfer_accumulators() handles for these flags. */
+    std::vector<struct accumulators_st *> accumulators() {
+        std::vector<struct accumulators_st *> all;
+        for (int y = 0; y < nYears; y++) {
+            all.push_back(&_Grp[0].s[y]);
+            all.push_back(&_Spp[0].s[y]);
+            all.push_back(&_Sreceived[0].s[y]);
+        }
+        return all;
+    }
+
+    FILE *file;
+};
+
+/* The same running update as _collect_add in ST_stats.c. */
+void collect(struct accumulators_st *p, double v) {
+    p->nobs++;
+    RealF old_ave = p->ave;
+    p->ave = get_running_mean(p->nobs, p->ave, v);
+    p->sum_dif_sqr += get_running_sqr(old_ave, p->ave, v);
+    p->sd = final_running_sd(p->nobs, p->sum_dif_sqr);
+}
+
+/* Observation i of accumulator a, made up so that no two are equal. */
+double observation(size_t a, int i) {
+    return 10.0 * a + 1.5 * i + (i % 3) * 0.25;
+}
+
+void expect_same(const struct accumulators_st &a, const struct accumulators_st &b) {
+    EXPECT_EQ(a.nobs, b.nobs);
+    EXPECT_EQ(a.ave, b.ave);
+    EXPECT_EQ(a.sum_dif_sqr, b.sum_dif_sqr);
+    EXPECT_EQ(a.sd, b.sd);
+}
+
+TEST_F(AccumulatorTest, WriteThenReadRestoresEveryAccumulator) {
+    std::vector<struct accumulators_st> expected;
+    auto all = accumulators();
+
+    for (size_t a = 0; a < all.size(); a++) {
+        for (int i = 0; i < 4; i++) {
+            collect(all[a], observation(a, i));
+        }
+        expected.push_back(*all[a]);
+    }
+
+    ASSERT_TRUE(stat_Write_Accumulators(file));
+    stat_Clear_Accumulators();
+    EXPECT_EQ(_Sreceived[0].s[0].nobs, 0u);
+
+    rewind(file);
+    ASSERT_TRUE(stat_Read_Accumulators(file));
+    for (size_t a = 0; a < all.size(); a++) {
+        expect_same(*all[a], expected[a]);
+    }
+}
+
+TEST_F(AccumulatorTest, ReadFailsOnTruncatedFile) {
+    ASSERT_TRUE(stat_Write_Accumulators(file));
+    long size = ftell(file);
+
+    FILE *truncated = tmpfile();
+    ASSERT_NE(truncated, nullptr);
+    rewind(file);
+    std::vector<char> bytes(size - 1);
+    ASSERT_EQ(fread(bytes.data(), 1, bytes.size(), file), bytes.size());
+    fwrite(bytes.data(), 1, bytes.size(), truncated);
+    rewind(truncated);
+
+    EXPECT_FALSE(stat_Read_Accumulators(truncated));
+    fclose(truncated);
+}
+
+/* Merging one iteration at a time, as the -j parent does, must give exactly
+   what collecting every iteration in one process gives. */
+TEST_F(AccumulatorTest, MergingSingleIterationsMatchesSerialCollection) {
+    const int nIterations = 7;
+    auto all = accumulators();
+    std::vector<struct accumulators_st> serial(all.size());
+
+    for (size_t a = 0; a < all.size(); a++) {
+        for (int i = 0; i < nIterations; i++) {
+            collect(&serial[a], observation(a, i));
+        }
+    }
+
+    stat_Clear_Accumulators();
+    for (int i = 0; i < nIterations; i++) {
+        // What one worker sends for iteration i
+        std::vector<struct accumulators_st> saved;
+        for (size_t a = 0; a < all.size(); a++) {
+            saved.push_back(*all[a]);
+            *all[a] = accumulators_st();
+            collect(all[a], observation(a, i));
+        }
+        FILE *iteration = tmpfile();
+        ASSERT_TRUE(stat_Write_Accumulators(iteration));
+        for (size_t a = 0; a < all.size(); a++) {
+            *all[a] = saved[a];
+        }
+
+        rewind(iteration);
+        ASSERT_TRUE(stat_Merge_Accumulators(iteration));
+        fclose(iteration);
+    }
+
+    for (size_t a = 0; a < all.size(); a++) {
+        expect_same(*all[a], serial[a]);
+    }
+}
+
+/* Blocks of several observations are combined with the update of Chan,
+   Golub and LeVeque, which agrees with the serial reference up to rounding. */
+TEST_F(AccumulatorTest, ChanMergeMatchesSerialReference) {
+    const int nFirst = 5, nSecond = 9;
+    auto all = accumulators();
+    std::vector<struct accumulators_st> serial(all.size()), second(all.size());
+
+    for (size_t a = 0; a < all.size(); a++) {
+        for (int i = 0; i < nFirst + nSecond; i++) {
+            collect(&serial[a], observation(a, i));
+            collect(i < nFirst ? all[a] : &second[a], observation(a, i));
+        }
+    }
+
+    // Write the second block and merge it into the first.
+    std::vector<struct accumulators_st> first;
+    for (size_t a = 0; a < all.size(); a++) {
+        first.push_back(*all[a]);
+        *all[a] = second[a];
+    }
+    ASSERT_TRUE(stat_Write_Accumulators(file));
+    for (size_t a = 0; a < all.size(); a++) {
+        *all[a] = first[a];
+    }
+    rewind(file);
+    ASSERT_TRUE(stat_Merge_Accumulators(file));
+
+    for (size_t a = 0; a < all.size(); a++) {
+        EXPECT_EQ(all[a]->nobs, serial[a].nobs);
+        EXPECT_NEAR(all[a]->ave, serial[a].ave, 1e-6 * fabs(serial[a].ave));
+        EXPECT_NEAR(all[a]->sum_dif_sqr, serial[a].sum_dif_sqr, 1e-4 * serial[a].sum_dif_sqr);
+        EXPECT_NEAR(all[a]->sd, serial[a].sd, 1e-4 * serial[a].sd);
+    }
+}
+
+TEST_F(AccumulatorTest, MergingIntoEmptyAccumulatorsCopies) {
+    auto all = accumulators();
+    std::vector<struct accumulators_st> expected;
+
+    for (size_t a = 0; a < all.size(); a++) {
+        for (int i = 0; i < 3; i++) {
+            collect(all[a], observation(a, i));
+        }
+        expected.push_back(*all[a]);
+    }
+    ASSERT_TRUE(stat_Write_Accumulators(file));
+    stat_Clear_Accumulators();
+
+    rewind(file);
+    ASSERT_TRUE(stat_Merge_Accumulators(file));
+    for (size_t a = 0; a < all.size(); a++) {
+        expect_same(*all[a], expected[a]);
+    }
+}
+
+}  // namespace
@@ -0,0 +1,19 @@
+#ifndef TEST_ST_STATS_H
+#define TEST_ST_STATS_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_defines.h"
+#include "ST_globals.h"
+#include "ST_stats.h"
+}
+
+// From ST_stats.c
+extern StatType *_Grp, *_Spp, *_Sreceived;
+
+// From ST_seedDispersal.h
+extern Bool UseSeedDispersal;
+
+#endif
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "test_sxw_resource.h"
+
+namespace {
+
+const int nGroups = 5, nTrLyrs = 4, nSoLyrs = 6, nPds = MAX_MONTHS;
+// Veg type of each group and transpiration layers of each veg type, so that
+// groups use different numbers of layers and share veg types.
+const int vegTypes[nGroups] = {0, 1, 1, 2, 3};
+const int transpLayers[NVEGTYPES] = {4, 2, 3, 1};
+
+/* The root tables and the group transpiration as the loops over group,
+   layer and month computed them before they were fused. */
+struct Reference {
+    std::vector<RealD> active, rel, sum, use;
+};
+
+Reference referenceTables(const RealF sizes[]) {
+    Reference r;
+    r.active.assign(nGroups * nTrLyrs * nPds, 0.);
+    r.rel.assign(nGroups * nTrLyrs * nPds, 0.);
+    r.sum.assign(NVEGTYPES * nTrLyrs * nPds, 0.);
+    r.use.assign(nGroups, 0.);
+
+    for (int g = 0; g < nGroups; g++) {
+        for (int l = 0; l < transpLayers[vegTypes[g]]; l++) {
+            for (int p = 0; p < nPds; p++) {
+                RealD x = SXWResources->_rootsXphen[Iglp(g, l, p)] * sizes[g];
+                r.active[Iglp(g, l, p)] = x;
+                r.sum[Itlp(vegTypes[g], l, p)] += x;
+            }
+        }
+    }
+    for (int g = 0; g < nGroups; g++) {
+        for (int l = 0; l < transpLayers[vegTypes[g]]; l++) {
+            for (int p = 0; p < nPds; p++) {
+                RealD all = 0.;
+                for (int t = 0; t < NVEGTYPES; t++) {
+                    all += r.sum[Itlp(t, l, p)];
+                }
+                r.rel[Iglp(g, l, p)] = ZRO(all) ? 0. : r.active[Iglp(g, l, p)] / all;
+            }
+        }
+    }
+    for (int g = 0; g < nGroups; g++) {
+        for (int p = 0; p < nPds; p++) {
+            for (int l = 0; l < transpLayers[vegTypes[g]]; l++) {
+                r.use[g] += r.rel[Iglp(g, l, p)] * SXW->transpTotal[Ilp(l, p)];
+            }
+        }
+    }
+    return r;
+}
+
+class RootTablesTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Globals = (ModelType *)Mem_Calloc(1, sizeof(ModelType), nullptr);
+        Globals->grpCount = nGroups;
+        RGroup = (GroupType **)Mem_Calloc(nGroups, sizeof(GroupType *), nullptr);
+        for (int g = 0; g < nGroups; g++) {
+            RGroup[g] = (GroupType *)Mem_Calloc(1, sizeof(GroupType), nullptr);
+            RGroup[g]->veg_prod_type = vegTypes[g];
+        }
+        for (int t = 0; t < NVEGTYPES; t++) {
+            SW_Site.n_transp_lyrs[t] = transpLayers[t];
+        }
+
+        SXW = (SXW_t *)Mem_Calloc(1, sizeof(SXW_t), nullptr);
+        SXW->NGrps = nGroups;
+        SXW->NTrLyrs = nTrLyrs;
+        SXW->NSoLyrs = nSoLyrs;
+        SXW->NPds = nPds;
+        SXW->transpTotal = (RealD *)Mem_Calloc(nSoLyrs * nPds, sizeof(RealD), nullptr);
+
+        SXWResources = (SXW_resourceType *)Mem_Calloc(1, sizeof(SXW_resourceType), nullptr);
+        SXWResources->_rootsXphen = (RealD *)Mem_Calloc(nGroups * nTrLyrs * nPds, sizeof(RealD), nullptr);
+        SXWResources->_roots_active = (RealD *)Mem_Calloc(nGroups * nTrLyrs * nPds, sizeof(RealD), nullptr);
+        SXWResources->_roots_active_rel = (RealD *)Mem_Calloc(nGroups * nTrLyrs * nPds, sizeof(RealD), nullptr);
+        SXWResources->_roots_active_sum = (RealD *)Mem_Calloc(NVEGTYPES * nTrLyrs * nPds, sizeof(RealD), nullptr);
+
+        srand(17);
+        for (int i = 0; i < nGroups * nTrLyrs * nPds; i++) {
+            SXWResources->_rootsXphen[i] = (rand() % 1000) / 1000.;
+        }
+        for (int i = 0; i < nSoLyrs * nPds; i++) {
+            SXW->transpTotal[i] = (rand() % 1000) / 100.;
+        }
+    }
+
+    void TearDown() override {
+        scratch_Free();
+        Mem_Free(SXWResources->_roots_active_sum);
+        Mem_Free(SXWResources->_roots_active_rel);
+        Mem_Free(SXWResources->_roots_active);
+        Mem_Free(SXWResources->_rootsXphen);
+        Mem_Free(SXWResources);
+        Mem_Free(SXW->transpTotal);
+        Mem_Free(SXW);
+        for (int g = 0; g < nGroups; g++) {
+            Mem_Free(RGroup[g]);
+        }
+        Mem_Free(RGroup);
+        Mem_Free(Globals);
+    }
+
+    /* Run the fused kernel and compare it with the reference. The tables
+       are computed with the same operations in the same order, so they
+       must match exactly; the group sums are added in a different order. */
+    void expectReference(RealF sizes[]) {
+        RealD use[nGroups];
+        Reference r = referenceTables(sizes);
+
+        _sxw_update_root_tables(sizes, use);
+
+        for (size_t i = 0; i < r.active.size(); i++) {
+            EXPECT_EQ(r.active[i], SXWResources->_roots_active[i]) << "cell " << i;
+            EXPECT_EQ(r.rel[i], SXWResources->_roots_active_rel[i]) << "cell " << i;
+        }
+        for (size_t i = 0; i < r.sum.size(); i++) {
+            EXPECT_EQ(r.sum[i], SXWResources->_roots_active_sum[i]) << "cell " << i;
+        }
+        for (int g = 0; g < nGroups; g++) {
+            EXPECT_NEAR(r.use[g], use[g], 1e-12 * std::fabs(r.use[g]) + 1e-12) << "group " << g;
+        }
+    }
+};
+
+TEST_F(RootTablesTest, MatchesSeparatePasses) {
+    RealF sizes[nGroups] = {120.f, 35.5f, 0.25f, 80.f, 3.f};
+    expectReference(sizes);
+}
+
+TEST_F(RootTablesTest, GroupsWithoutBiomass) {
+    // Layers and months where no group has active roots get no weight.
+    RealF sizes[nGroups] = {0.f, 10.f, 0.f, 0.f, 5.f};
+    expectReference(sizes);
+
+    RealF none[nGroups] = {0.f, 0.f, 0.f, 0.f, 0.f};
+    expectReference(none);
+}
+
+TEST_F(RootTablesTest, WeightsSumToOne) {
+    RealF sizes[nGroups] = {120.f, 35.5f, 0.25f, 80.f, 3.f};
+    RealD use[nGroups];
+
+    _sxw_update_root_tables(sizes, use);
+
+    // Every layer and month that some group reaches is split up completely.
+    for (int l = 0; l < nTrLyrs; l++) {
+        for (int p = 0; p < nPds; p++) {
+            RealD sum = 0.;
+            for (int g = 0; g < nGroups; g++) {
+                if (l < transpLayers[vegTypes[g]]) {
+                    sum += SXWResources->_roots_active_rel[Iglp(g, l, p)];
+                }
+            }
+            EXPECT_NEAR(1., sum, 1e-12) << "layer " << l << ", month " << p;
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,20 @@
+#ifndef TEST_SXW_RESOURCE_H
+#define TEST_SXW_RESOURCE_H
+
+#include "sw_src/generic.h"
+#include "sw_src/myMemory.h"
+
+extern "C" {
+#include "ST_defines.h"
+#include "ST_globals.h"
+#include "ST_scratch.h"
+#include "sxw.h"
+#include "sxw_module.h"
+}
+
+// From sxw.c and SOILWAT2
+extern SXW_t *SXW;
+extern SXW_resourceType *SXWResources;
+extern SW_SITE SW_Site;
+
+#endif